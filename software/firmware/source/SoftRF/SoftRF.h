@@ -107,14 +107,14 @@
 #define ENABLE_AHRS
 #endif /* PREMIUM_PACKAGE */
 
+/*
+ * Hot part of an object: what the traffic table, alarms and exporters
+ * work with. Fields are grouped by size to keep the record compact.
+ */
 typedef struct UFO {
-    uint8_t   raw[34];
     time_t    timestamp;
-
-    uint8_t   protocol;
-
     uint32_t  addr;
-    uint8_t   addr_type;
+
     float     latitude;
     float     longitude;
     float     altitude;
@@ -122,9 +122,18 @@ typedef struct UFO {
     float     course;     /* CoG */
     float     speed;      /* ground speed in knots */
     float     turnRate;   /* deg per sec */
-    uint8_t   aircraft_type;
-
     float     vs; /* feet per minute */
+    float     geoid_separation; /* metres */
+
+    /* 'legacy' specific data */
+    float     distance;
+    float     bearing;
+
+    uint16_t  hdop; /* cm */
+
+    uint8_t   protocol;
+    uint8_t   addr_type;
+    uint8_t   aircraft_type;
 
     bool      stealth;
     bool      no_track;
@@ -132,24 +141,31 @@ typedef struct UFO {
     int8_t    flying;   // >= 25 knots
     int8_t    turning;  // 0 right, 1 straight, 3 left
 
-    int8_t    ns[4];    // not really needed, use turnRate instead
+    int8_t    ns[4];    // extrapolated velocity vectors, used by CPA alarm
     int8_t    ew[4];
 
-    float     geoid_separation; /* metres */
-    uint16_t  hdop; /* cm */
     int8_t    rssi; /* SX1276 only */
-
-    /* 'legacy' specific data */
-    float     distance;
-    float     bearing;
     int8_t    alarm_level;
 
     /* bitmap of issued voice/tone/ble/... alerts */
     uint8_t   alert;
+} ufo_t;
+
+#define UFO_SOURCES       8 /* one per RF_PROTOCOL_... value */
+
+/*
+ * Cold part of an object, rarely touched after reception.
+ * Use Traffic_Cold() to get one for a given ufo_t.
+ */
+typedef struct UFO_Cold {
+    uint8_t   raw[34];
 
     /* ADS-B (ES, UAT, GDL90) specific data */
     uint8_t   callsign[8];
-} ufo_t;
+
+    /* time of the last report per protocol, for fused table entries */
+    time_t    source_time[UFO_SOURCES];
+} ufo_cold_t;
 
 typedef struct hardware_info {
     byte  model;
@@ -502,15 +502,15 @@ void bridge()
   if(success)
   {
     size_t rx_size = RF_Payload_Size(settings->rf_protocol);
-    rx_size = rx_size > sizeof(fo.raw) ? sizeof(fo.raw) : rx_size;
+    rx_size = rx_size > sizeof(fo_cold.raw) ? sizeof(fo_cold.raw) : rx_size;
 
-    memset(fo.raw, 0, sizeof(fo.raw));
-    memcpy(fo.raw, RxBuffer, rx_size);
+    memset(fo_cold.raw, 0, sizeof(fo_cold.raw));
+    memcpy(fo_cold.raw, RxBuffer, rx_size);
 
     if (settings->nmea_p) {
       StdOut.print(F("$PSRFI,"));
       StdOut.print((unsigned long) now());    StdOut.print(F(","));
-      StdOut.print(Bin2Hex(fo.raw, rx_size)); StdOut.print(F(","));
+      StdOut.print(Bin2Hex(fo_cold.raw, rx_size)); StdOut.print(F(","));
       StdOut.println(RF_last_rssi);
     }
 
@@ -533,15 +533,15 @@ void watchout()
 
   if (success) {
     size_t rx_size = RF_Payload_Size(settings->rf_protocol);
-    rx_size = rx_size > sizeof(fo.raw) ? sizeof(fo.raw) : rx_size;
+    rx_size = rx_size > sizeof(fo_cold.raw) ? sizeof(fo_cold.raw) : rx_size;
 
-    memset(fo.raw, 0, sizeof(fo.raw));
-    memcpy(fo.raw, RxBuffer, rx_size);
+    memset(fo_cold.raw, 0, sizeof(fo_cold.raw));
+    memcpy(fo_cold.raw, RxBuffer, rx_size);
 
     if (settings->nmea_p) {
       StdOut.print(F("$PSRFI,"));
       StdOut.print((unsigned long) now());    StdOut.print(F(","));
-      StdOut.print(Bin2Hex(fo.raw, rx_size)); StdOut.print(F(","));
+      StdOut.print(Bin2Hex(fo_cold.raw, rx_size)); StdOut.print(F(","));
       StdOut.println(RF_last_rssi);
     }
   }
@@ -546,7 +546,7 @@ bool s7xg_receive()
   return success;
 }
 
-void s7xg_transmit()
+bool s7xg_transmit()
 {
   char hex_tx_buf[2 * MAX_PKT_SIZE + 1];
   uint8_t tmp;
@@ -568,7 +568,11 @@ void s7xg_transmit()
     hex_tx_buf[i+i] = 0;
 
     s7xg.loraTransmit(hex_tx_buf);
+
+    return true;
   }
+
+  return false;
 }
 
 void s7xg_shutdown()
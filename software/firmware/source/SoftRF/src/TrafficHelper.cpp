@@ -24,11 +24,64 @@
 #include "ui/Web.h"
 #include "protocol/radio/Legacy.h"
 
+#if defined(USE_TRAFFIC_SNAPSHOT)
+#include <atomic>
+#include "protocol/data/JSON.h"
+#endif /* USE_TRAFFIC_SNAPSHOT */
+
 unsigned long UpdateTrafficTimeMarker = 0;
 
 ufo_t fo, Container[MAX_TRACKING_OBJECTS], EmptyFO;
+ufo_cold_t fo_cold, EmptyFO_Cold;
+static ufo_cold_t Container_Cold[MAX_TRACKING_OBJECTS];
 traffic_by_dist_t traffic_by_dist[MAX_TRACKING_OBJECTS];
 
+/*
+ * First Traffic_Live_Count elements of Traffic_Slots[] are indices
+ * of Container[] slots in use, the rest are free slots.
+ * Slots above Traffic_Slots_Used have never been handed out yet,
+ * which keeps zero initialized state of these arrays valid.
+ */
+uint16_t Traffic_Slots[MAX_TRACKING_OBJECTS];
+static uint16_t Traffic_Slot_Pos[MAX_TRACKING_OBJECTS];
+static int Traffic_Live_Count = 0;
+static int Traffic_Slots_Used = 0;
+
+/* Container[] slot index + 1 of an entry, zero is an empty bucket */
+static uint16_t Traffic_Hash[TRAFFIC_HASH_SIZE];
+
+/*
+ * Binary min-heap of live slots, ordered by (alarm_level, -distance).
+ * Its top is the first candidate for eviction when the table is full.
+ */
+static uint16_t Traffic_Heap[MAX_TRACKING_OBJECTS];
+static uint16_t Traffic_Heap_Pos[MAX_TRACKING_OBJECTS];
+
+/*
+ * Hashed timing wheel with one second ticks. Every indexed entry is
+ * linked into the bucket of the second it expires at, so ClearExpired()
+ * only visits the buckets of the seconds that have passed since its last
+ * call. List links are Container[] slot index + 1, zero ends a list.
+ */
+static uint16_t Traffic_Wheel[TRAFFIC_WHEEL_SIZE];
+static uint16_t Traffic_Wheel_Next[MAX_TRACKING_OBJECTS];
+static uint16_t Traffic_Wheel_Prev[MAX_TRACKING_OBJECTS];
+static time_t   Traffic_Expiry[MAX_TRACKING_OBJECTS];
+static time_t   Traffic_Wheel_Time = 0;
+
+/*
+ * Positions of table entries and their relative geometry,
+ * kept as structure of arrays indexed by Container[] slot.
+ */
+traffic_geometry_t Traffic_Geometry;
+
+/* Own-ship reference point of the local tangent (ENU) plane */
+static float Traffic_Ref_Lat   = 0.0;
+static float Traffic_Ref_Lon   = 0.0;
+static float Traffic_Ref_Alt   = 0.0;
+static float Traffic_Ref_Cos   = 1.0;
+static float Traffic_Ref_Sin   = 0.0;
+
 static int8_t (*Alarm_Level)(ufo_t *, ufo_t *);
 
 /*
@@ -62,6 +115,59 @@ static int8_t Alarm_Distance(ufo_t *this_aircraft, ufo_t *fop)
   return rval;
 }
 
+/*
+ * Own-ship motion cache. Trajectory is relative to current own position,
+ * so it only has to be rebuilt when GS, CoG or turn rate change.
+ */
+static float Ownship_Speed    = 0.0;
+static float Ownship_Course   = 0.0;
+static float Ownship_TurnRate = 0.0;
+static float Ownship_V_north  = 0.0;  /* knots */
+static float Ownship_V_east   = 0.0;
+static float Ownship_North[ALARM_CPA_HORIZON + 1];  /* metres, t = 0, 1, ... */
+static float Ownship_East [ALARM_CPA_HORIZON + 1];
+static bool  Ownship_Valid    = false;
+
+static void Traffic_Ownship_Motion(ufo_t *this_aircraft)
+{
+  if (Ownship_Valid &&
+      this_aircraft->speed    == Ownship_Speed  &&
+      this_aircraft->course   == Ownship_Course &&
+      this_aircraft->turnRate == Ownship_TurnRate) {
+    return;
+  }
+
+  Ownship_Speed    = this_aircraft->speed;
+  Ownship_Course   = this_aircraft->course;
+  Ownship_TurnRate = this_aircraft->turnRate;
+
+  float rad = Ownship_Course * (float) DEG_TO_RAD;
+  Ownship_V_north = Ownship_Speed * cosf(rad);
+  Ownship_V_east  = Ownship_Speed * sinf(rad);
+
+  /* constant turn, heading of every 1 s step is taken at its middle */
+  float v   = Ownship_Speed * (float) _GPS_MPS_PER_KNOT;
+  float rot = Ownship_TurnRate * (float) DEG_TO_RAD;
+  float c   = cosf(rad + rot * 0.5f);
+  float s   = sinf(rad + rot * 0.5f);
+  float rc  = cosf(rot);
+  float rs  = sinf(rot);
+
+  Ownship_North[0] = 0.0f;
+  Ownship_East[0]  = 0.0f;
+
+  for (int t = 1; t <= ALARM_CPA_HORIZON; t++) {
+    Ownship_North[t] = Ownship_North[t-1] + v * c;
+    Ownship_East[t]  = Ownship_East[t-1]  + v * s;
+
+    float c1 = c * rc - s * rs;
+    s = s * rc + c * rs;
+    c = c1;
+  }
+
+  Ownship_Valid = true;
+}
+
 /*
  * EXPERIMENTAL
  *
@@ -74,11 +180,12 @@ static int8_t Alarm_Vector(ufo_t *this_aircraft, ufo_t *fop)
 
   if (abs(alt_diff) < VERTICAL_SEPARATION) { /* no warnings if too high or too low */
 
+    Traffic_Ownship_Motion(this_aircraft);
+
     /* Subtract 2D velocity vector of traffic from 2D velocity vector of this aircraft */ 
-    float V_rel_x = this_aircraft->speed * cosf(radians(90.0 - this_aircraft->course)) -
-                    fop->speed * cosf(radians(90.0 - fop->course)) ;
-    float V_rel_y = this_aircraft->speed * sinf(radians(90.0 - this_aircraft->course)) -
-                    fop->speed * sinf(radians(90.0 - fop->course)) ;
+    float rad = fop->course * (float) DEG_TO_RAD;
+    float V_rel_x = Ownship_V_east  - fop->speed * sinf(rad);
+    float V_rel_y = Ownship_V_north - fop->speed * cosf(rad);
 
     float V_rel_magnitude = sqrtf(V_rel_x * V_rel_x + V_rel_y * V_rel_y) * _GPS_MPS_PER_KNOT;
     float V_rel_direction = atan2f(V_rel_y, V_rel_x) * 180.0 / PI;  /* -180 ... 180 */
@@ -108,50 +215,614 @@ static int8_t Alarm_Vector(ufo_t *this_aircraft, ufo_t *fop)
 
 /*
  * "Legacy" method is based on short history of 2D velocity vectors (NS/EW)
+ *
+ * Traffic is flown ahead in 1 s steps along its extrapolated NS/EW vectors
+ * (Legacy) or CoG and turn rate (other protocols), starting from the time
+ * of the report, and compared against precomputed own-ship trajectory.
+ * Closest point of approach is searched within every step, so the cost
+ * is bounded by ENTRY_EXPIRATION_TIME + ALARM_CPA_HORIZON steps per target.
  */
 static int8_t Alarm_Legacy(ufo_t *this_aircraft, ufo_t *fop)
 {
-
   int8_t rval = ALARM_LEVEL_NONE;
+  float alt_diff = fop->altitude - this_aircraft->altitude;
+
+  if (fabsf(alt_diff) >= VERTICAL_SEPARATION) { /* no warnings if too high or too low */
+    return rval;
+  }
+
+  int age = (int) (this_aircraft->timestamp - fop->timestamp);
+  age = age < 0 ? 0 : (age > ENTRY_EXPIRATION_TIME ? ENTRY_EXPIRATION_TIME : age);
+
+  float v = fop->speed * (float) _GPS_MPS_PER_KNOT;
+
+  /* out of reach within the look-ahead time */
+  if (fop->distance > ALARM_CPA_RADIUS +
+      (this_aircraft->speed * (float) _GPS_MPS_PER_KNOT + v) *
+      (ALARM_CPA_HORIZON + age)) {
+    return rval;
+  }
+
+  Traffic_Ownship_Motion(this_aircraft);
+
+  float rad = fop->bearing * (float) DEG_TO_RAD;
+  float n   = fop->distance * cosf(rad);
+  float e   = fop->distance * sinf(rad);
 
-  /* TBD */
+  /* unit vectors of extrapolated velocities and their times, if any */
+  float u_n[4], u_e[4];
+  int   T[4];
+  int   samples = 0;
+
+  if (fop->protocol == RF_PROTOCOL_LEGACY) {
+    const int32_t *ep = EP[fop->aircraft_type == AIRCRAFT_TYPE_GLIDER ? 0 : 1];
+
+    for (int j = 0; j < 4; j++) {
+      float m = sqrtf((float) (fop->ns[j] * fop->ns[j] + fop->ew[j] * fop->ew[j]));
+      if (m == 0.0f) {
+        break;
+      }
+      u_n[j] = fop->ns[j] / m;
+      u_e[j] = fop->ew[j] / m;
+      T[j]   = (j > 0 ? T[j-1] : 0) + ep[j];
+      samples++;
+    }
+    if (samples < 4) {
+      samples = 0;
+    }
+  }
+
+  float rot = fop->turnRate * (float) DEG_TO_RAD;
+  float c, s;
+
+  if (samples) {
+    c = u_n[0];
+    s = u_e[0];
+  } else {
+    float h = fop->course * (float) DEG_TO_RAD + rot * 0.5f;
+    c = cosf(h);
+    s = sinf(h);
+  }
+
+  float rc = cosf(rot);
+  float rs = sinf(rot);
+  int j = 0;
+
+  /* relative position at t = 0 is known right away for a fresh report */
+  float min_d2  = age == 0 ? n * n + e * e : -1.0f;
+  float min_t   = 0.0f;
+  float prev_n  = n;
+  float prev_e  = e;
+
+  for (int k = 1; k <= age + ALARM_CPA_HORIZON; k++) {
+    float m = k - 0.5f;
+
+    if (samples && m <= T[3]) {
+      /* nearest extrapolated vector */
+      while (j < 3 && m > (T[j] + T[j+1]) * 0.5f) {
+        j++;
+      }
+      c = u_n[j];
+      s = u_e[j];
+    } else if (k > 1) {
+      float c1 = c * rc - s * rs;
+      s = s * rc + c * rs;
+      c = c1;
+    }
+
+    n += v * c;
+    e += v * s;
+
+    int t = k - age;
+
+    if (t < 0) {
+      continue;
+    }
+
+    float rel_n = n - Ownship_North[t];
+    float rel_e = e - Ownship_East[t];
+
+    if (t == 0) {
+      prev_n = rel_n;
+      prev_e = rel_e;
+      min_d2 = rel_n * rel_n + rel_e * rel_e;
+      continue;
+    }
+
+    /* closest approach within the step, relative motion is linear */
+    float d_n  = rel_n - prev_n;
+    float d_e  = rel_e - prev_e;
+    float d_d  = d_n * d_n + d_e * d_e;
+    float tau  = d_d > 0.0f ? -(prev_n * d_n + prev_e * d_e) / d_d : 0.0f;
+
+    tau = tau < 0.0f ? 0.0f : (tau > 1.0f ? 1.0f : tau);
+
+    float q_n = prev_n + tau * d_n;
+    float q_e = prev_e + tau * d_e;
+    float d2  = q_n * q_n + q_e * q_e;
+
+    if (d2 < min_d2) {
+      min_d2 = d2;
+      min_t  = (t - 1) + tau;
+    }
+
+    prev_n = rel_n;
+    prev_e = rel_e;
+  }
+
+  if (min_d2 < 0.0f || min_d2 >= ALARM_CPA_RADIUS * ALARM_CPA_RADIUS) {
+    return rval;
+  }
+
+  /* vertical separation at CPA, vs is in feet per minute */
+  float climb = (fop->vs - this_aircraft->vs) / (_GPS_FEET_PER_METER * 60.0f);
+
+  if (fabsf(alt_diff + climb * min_t) >= VERTICAL_SEPARATION) {
+    return rval;
+  }
+
+  /* time limit values are compliant with FLARM data port specs */
+  if (min_t < 9.0f) {
+    rval = ALARM_LEVEL_URGENT;
+  } else if (min_t < 13.0f) {
+    rval = ALARM_LEVEL_IMPORTANT;
+  } else if (min_t < 19.0f) {
+    rval = ALARM_LEVEL_LOW;
+  }
 
   return rval;
 }
 
+static void Traffic_Project_Ownship()
+{
+  if (ThisAircraft.latitude  != Traffic_Ref_Lat ||
+      ThisAircraft.longitude != Traffic_Ref_Lon) {
+    Traffic_Ref_Lat = ThisAircraft.latitude;
+    Traffic_Ref_Lon = ThisAircraft.longitude;
+    Traffic_Ref_Cos = cosf(radians(Traffic_Ref_Lat));
+    Traffic_Ref_Sin = sinf(radians(Traffic_Ref_Lat));
+  }
+  Traffic_Ref_Alt = ThisAircraft.altitude;
+}
+
+/*
+ * Equirectangular projection around own-ship. Cosine of the mid latitude
+ * is taken to first order, which keeps distance within 0.01% of
+ * the great circle one up to 130 km.
+ */
+static inline void Traffic_Project(float latitude, float longitude,
+                                   float *north, float *east)
+{
+  float dlat = latitude  - Traffic_Ref_Lat;
+  float dlon = longitude - Traffic_Ref_Lon;
+
+  if (dlon >  180.0f) dlon -= 360.0f;
+  if (dlon < -180.0f) dlon += 360.0f;
+
+  *north = dlat * TRAFFIC_METRES_PER_DEGREE;
+  *east  = dlon * TRAFFIC_METRES_PER_DEGREE *
+           (Traffic_Ref_Cos - Traffic_Ref_Sin * dlat * (float) DEG_TO_RAD * 0.5f);
+}
+
+static inline float Traffic_Bearing(float north, float east)
+{
+  float bearing = atan2f(east, north) * (float) RAD_TO_DEG;
+
+  return bearing < 0.0f ? bearing + 360.0f : bearing;
+}
+
+/*
+ * Batched counterpart of Traffic_Update() geometry: one pass over
+ * all slots ever handed out, free ones are harmless to compute.
+ */
+static void Traffic_Geometry_Update()
+{
+  traffic_geometry_t *g = &Traffic_Geometry;
+  int n = Traffic_Slots_Used;
+
+  Traffic_Project_Ownship();
+
+  for (int i = 0; i < n; i++) {
+    float dlat = g->latitude[i]  - Traffic_Ref_Lat;
+    float dlon = g->longitude[i] - Traffic_Ref_Lon;
+
+    dlon = dlon >  180.0f ? dlon - 360.0f : dlon;
+    dlon = dlon < -180.0f ? dlon + 360.0f : dlon;
+
+    float north = dlat * TRAFFIC_METRES_PER_DEGREE;
+    float east  = dlon * TRAFFIC_METRES_PER_DEGREE *
+                  (Traffic_Ref_Cos - Traffic_Ref_Sin * dlat * (float) DEG_TO_RAD * 0.5f);
+
+    g->north[i]    = north;
+    g->east[i]     = east;
+    g->vertical[i] = g->altitude[i] - Traffic_Ref_Alt;
+    g->distance[i] = sqrtf(north * north + east * east);
+  }
+
+  for (int i = 0; i < n; i++) {
+    g->bearing[i] = Traffic_Bearing(g->north[i], g->east[i]);
+  }
+}
+
+/* Refresh geometry of one slot after its entry has been changed */
+static void Traffic_Geometry_Sync(uint16_t slot)
+{
+  traffic_geometry_t *g = &Traffic_Geometry;
+  ufo_t *fop = &Container[slot];
+
+  g->latitude[slot]  = fop->latitude;
+  g->longitude[slot] = fop->longitude;
+  g->altitude[slot]  = fop->altitude;
+
+  Traffic_Project(fop->latitude, fop->longitude, &g->north[slot], &g->east[slot]);
+  g->vertical[slot] = fop->altitude - Traffic_Ref_Alt;
+  g->distance[slot] = fop->distance;
+  g->bearing[slot]  = fop->bearing;
+}
+
 void Traffic_Update(ufo_t *fop)
 {
-  fop->distance = gnss.distanceBetween( ThisAircraft.latitude,
-                                        ThisAircraft.longitude,
-                                        fop->latitude,
-                                        fop->longitude);
+  float north, east;
+
+  Traffic_Project_Ownship();
+  Traffic_Project(fop->latitude, fop->longitude, &north, &east);
 
-  fop->bearing  = gnss.courseTo( ThisAircraft.latitude,
-                                 ThisAircraft.longitude,
-                                 fop->latitude,
-                                 fop->longitude);
+  fop->distance = sqrtf(north * north + east * east);
+  fop->bearing  = Traffic_Bearing(north, east);
 
   if (Alarm_Level) {
     fop->alarm_level = (*Alarm_Level)(&ThisAircraft, fop);
   }
+
+  Traffic_Reorder(fop);
 }
 
-void ParseData()
+static inline uint16_t Traffic_Hash_Home(uint32_t addr)
+{
+  /* Fibonacci hashing spreads adjacent IDs over the whole table */
+  return (uint16_t) (((uint32_t) (addr * 2654435769U)) >> (32 - TRAFFIC_HASH_BITS));
+}
+
+static void Traffic_Index(uint16_t slot)
+{
+  uint16_t i = Traffic_Hash_Home(Container[slot].addr);
+
+  while (Traffic_Hash[i]) {
+    i = (i + 1) & TRAFFIC_HASH_MASK;
+  }
+  Traffic_Hash[i] = slot + 1;
+}
+
+static void Traffic_Unindex(uint16_t slot)
+{
+  uint16_t i = Traffic_Hash_Home(Container[slot].addr);
+
+  while (Traffic_Hash[i] != slot + 1) {
+    if (Traffic_Hash[i] == 0) {
+      return;
+    }
+    i = (i + 1) & TRAFFIC_HASH_MASK;
+  }
+
+  /* backward shift deletion, no tombstones are left behind */
+  uint16_t j = i;
+
+  for (;;) {
+    j = (j + 1) & TRAFFIC_HASH_MASK;
+    if (Traffic_Hash[j] == 0) {
+      break;
+    }
+
+    uint16_t k = Traffic_Hash_Home(Container[Traffic_Hash[j] - 1].addr);
+
+    /* move the entry into the hole unless its home bucket is within (i, j] */
+    if ((i <= j) ? (i >= k || k > j) : (i >= k && k > j)) {
+      Traffic_Hash[i] = Traffic_Hash[j];
+      i = j;
+    }
+  }
+
+  Traffic_Hash[i] = 0;
+}
+
+static void Traffic_Wheel_Link(uint16_t slot)
+{
+  time_t expiry = Container[slot].timestamp + ENTRY_EXPIRATION_TIME + 1;
+  uint16_t bucket = expiry & TRAFFIC_WHEEL_MASK;
+
+  Traffic_Expiry[slot] = expiry;
+  Traffic_Wheel_Prev[slot] = 0;
+  Traffic_Wheel_Next[slot] = Traffic_Wheel[bucket];
+  if (Traffic_Wheel[bucket]) {
+    Traffic_Wheel_Prev[Traffic_Wheel[bucket] - 1] = slot + 1;
+  }
+  Traffic_Wheel[bucket] = slot + 1;
+}
+
+static void Traffic_Wheel_Unlink(uint16_t slot)
+{
+  uint16_t next = Traffic_Wheel_Next[slot];
+  uint16_t prev = Traffic_Wheel_Prev[slot];
+
+  if (prev) {
+    Traffic_Wheel_Next[prev - 1] = next;
+  } else {
+    Traffic_Wheel[Traffic_Expiry[slot] & TRAFFIC_WHEEL_MASK] = next;
+  }
+  if (next) {
+    Traffic_Wheel_Prev[next - 1] = prev;
+  }
+}
+
+/* Lower alarm level goes first, then the most distant one */
+static inline bool Traffic_Evicts_Before(uint16_t a, uint16_t b)
+{
+  if (Container[a].alarm_level != Container[b].alarm_level) {
+    return Container[a].alarm_level < Container[b].alarm_level;
+  }
+
+  return Container[a].distance > Container[b].distance;
+}
+
+static inline void Traffic_Heap_Set(uint16_t pos, uint16_t slot)
+{
+  Traffic_Heap[pos] = slot;
+  Traffic_Heap_Pos[slot] = pos;
+}
+
+static void Traffic_Heap_Sift(uint16_t pos)
+{
+  uint16_t slot = Traffic_Heap[pos];
+
+  while (pos > 0) {
+    uint16_t parent = (pos - 1) >> 1;
+    if (!Traffic_Evicts_Before(slot, Traffic_Heap[parent])) {
+      break;
+    }
+    Traffic_Heap_Set(pos, Traffic_Heap[parent]);
+    pos = parent;
+  }
+
+  for (;;) {
+    uint16_t child = (pos << 1) + 1;
+    if (child >= Traffic_Live_Count) {
+      break;
+    }
+    if (child + 1 < Traffic_Live_Count &&
+        Traffic_Evicts_Before(Traffic_Heap[child + 1], Traffic_Heap[child])) {
+      child++;
+    }
+    if (!Traffic_Evicts_Before(Traffic_Heap[child], slot)) {
+      break;
+    }
+    Traffic_Heap_Set(pos, Traffic_Heap[child]);
+    pos = child;
+  }
+
+  Traffic_Heap_Set(pos, slot);
+}
+
+static bool Traffic_Is_Live(ufo_t *fop)
+{
+  if (fop < Container || fop >= Container + MAX_TRACKING_OBJECTS) {
+    return false;
+  }
+
+  uint16_t slot = fop - Container;
+  uint16_t pos  = Traffic_Slot_Pos[slot];
+
+  return pos < Traffic_Live_Count && Traffic_Slots[pos] == slot;
+}
+
+/*
+ * Restore eviction order and expiry time of a table entry
+ * after its timestamp, distance or alarm level has been changed.
+ * Objects that are not in the table are ignored.
+ */
+void Traffic_Reorder(ufo_t *fop)
+{
+  if (Traffic_Is_Live(fop)) {
+    uint16_t slot = fop - Container;
+
+    Traffic_Heap_Sift(Traffic_Heap_Pos[slot]);
+    Traffic_Geometry_Sync(slot);
+
+    if (fop->addr &&
+        Traffic_Expiry[slot] != fop->timestamp + ENTRY_EXPIRATION_TIME + 1) {
+      Traffic_Wheel_Unlink(slot);
+      Traffic_Wheel_Link(slot);
+    }
+  }
+}
+
+/* Best candidate for eviction, NULL when the table is empty */
+ufo_t *Traffic_Victim()
+{
+  return Traffic_Live_Count > 0 ? &Container[Traffic_Heap[0]] : NULL;
+}
+
+/*
+ * Entry of the aircraft with this ID. The type is a part of the ID:
+ * a random or anonymous address, or one of a P3I or FANET device,
+ * may be equal to an unrelated ICAO one.
+ */
+ufo_t *Traffic_Lookup(uint32_t addr, uint8_t addr_type)
+{
+  if (addr == 0) {
+    return NULL;
+  }
+
+  uint16_t i = Traffic_Hash_Home(addr);
+
+  while (Traffic_Hash[i]) {
+    ufo_t *fop = &Container[Traffic_Hash[i] - 1];
+    if (fop->addr == addr && fop->addr_type == addr_type) {
+      return fop;
+    }
+    i = (i + 1) & TRAFFIC_HASH_MASK;
+  }
+
+  return NULL;
+}
+
+/*
+ * Put a new object into a free slot.
+ * Entries with zero address (raw data) are not indexed.
+ * Returns NULL when the table is full.
+ */
+ufo_t *Traffic_Insert(ufo_t *fop)
+{
+  if (Traffic_Live_Count >= MAX_TRACKING_OBJECTS) {
+    return NULL;
+  }
+
+  if (Traffic_Live_Count == Traffic_Slots_Used) {
+    Traffic_Slots[Traffic_Slots_Used] = Traffic_Slots_Used;
+    Traffic_Slots_Used++;
+  }
+
+  uint16_t slot = Traffic_Slots[Traffic_Live_Count];
+  Traffic_Slot_Pos[slot] = Traffic_Live_Count++;
+
+  Container[slot] = *fop;
+  Container_Cold[slot] = *Traffic_Cold(fop);
+  memset(Container_Cold[slot].source_time, 0, sizeof(Container_Cold[slot].source_time));
+  if (fop->protocol < UFO_SOURCES) {
+    Container_Cold[slot].source_time[fop->protocol] = fop->timestamp;
+  }
+  if (fop->addr) {
+    Traffic_Index(slot);
+    Traffic_Wheel_Link(slot);
+  }
+
+  Traffic_Heap_Set(Traffic_Live_Count - 1, slot);
+  Traffic_Heap_Sift(Traffic_Live_Count - 1);
+  Traffic_Geometry_Sync(slot);
+
+  return &Container[slot];
+}
+
+void Traffic_Remove(ufo_t *fop)
 {
-    size_t rx_size = RF_Payload_Size(settings->rf_protocol);
-    rx_size = rx_size > sizeof(fo.raw) ? sizeof(fo.raw) : rx_size;
+  uint16_t slot = fop - Container;
+  uint16_t pos  = Traffic_Slot_Pos[slot];
+  uint16_t last = Traffic_Live_Count - 1;
+
+  if (fop->addr) {
+    Traffic_Unindex(slot);
+    Traffic_Wheel_Unlink(slot);
+  }
+
+  /* move the last live slot into the hole, freed slot goes next to it */
+  Traffic_Slots[pos] = Traffic_Slots[last];
+  Traffic_Slot_Pos[Traffic_Slots[pos]] = pos;
+  Traffic_Slots[last] = slot;
+  Traffic_Slot_Pos[slot] = last;
+
+  /* same for the heap, then put the moved element in order */
+  uint16_t heap_pos = Traffic_Heap_Pos[slot];
+  Traffic_Heap_Set(heap_pos, Traffic_Heap[last]);
+  Traffic_Live_Count--;
+  if (heap_pos < Traffic_Live_Count) {
+    Traffic_Heap_Sift(heap_pos);
+  }
+
+  *fop = EmptyFO;
+}
+
+/*
+ * Cold record of an object. Table entries and fo have their own ones,
+ * anything else (e.g. ThisAircraft) gets a blank scratch record.
+ * Keeps decoders' and exporters' ufo_t based signatures as they are.
+ */
+ufo_cold_t *Traffic_Cold(ufo_t *fop)
+{
+  static ufo_cold_t scratch;
+
+  if (fop >= Container && fop < Container + MAX_TRACKING_OBJECTS) {
+    return &Container_Cold[fop - Container];
+  }
+  if (fop == &fo) {
+    return &fo_cold;
+  }
+
+  scratch = EmptyFO_Cold;
+  return &scratch;
+}
+
+/* Put a received frame straight into the cold record of an entry */
+static void Traffic_Cold_Fill(ufo_t *fop, size_t rx_size)
+{
+  ufo_cold_t *cold = Traffic_Cold(fop);
+
+  memcpy(cold->raw, RxBuffer, rx_size);
+  memset(cold->raw + rx_size, 0, sizeof(cold->raw) - rx_size);
+  if (fo_cold.callsign[0]) {
+    memcpy(cold->callsign, fo_cold.callsign, sizeof(cold->callsign));
+  }
+}
+
+/*
+ * Fuse a report into the table entry of the same aircraft, whichever
+ * protocol it came by. The freshest report sets position and velocity,
+ * data that only some sources carry is kept from the others.
+ */
+void Traffic_Merge(ufo_t *fop, ufo_t *nfo)
+{
+  ufo_cold_t *cold = Traffic_Cold(fop);
+
+  if (nfo->protocol < UFO_SOURCES) {
+    cold->source_time[nfo->protocol] = nfo->timestamp;
+  }
+
+  if (nfo->timestamp >= fop->timestamp) {
+    float   pressure_altitude = fop->pressure_altitude;
+    uint8_t aircraft_type     = fop->aircraft_type;
+    uint8_t alert             = fop->alert;
+
+    *fop = *nfo;
+
+    if (fop->pressure_altitude == 0.0 && pressure_altitude != 0.0) {
+      fop->pressure_altitude = pressure_altitude;
+    }
+    if (fop->aircraft_type == AIRCRAFT_TYPE_UNKNOWN) {
+      fop->aircraft_type = aircraft_type;
+    }
+    fop->alert = alert;
+  } else {
+    /* late report, fill in the blanks only */
+    if (fop->pressure_altitude == 0.0) {
+      fop->pressure_altitude = nfo->pressure_altitude;
+    }
+    if (fop->aircraft_type == AIRCRAFT_TYPE_UNKNOWN) {
+      fop->aircraft_type = nfo->aircraft_type;
+    }
+  }
+
+  Traffic_Reorder(fop);
+}
+
+/* Evict an entry in favour of a new object */
+ufo_t *Traffic_Replace(ufo_t *old_fop, ufo_t *new_fop)
+{
+  Traffic_Remove(old_fop);
+
+  return Traffic_Insert(new_fop);
+}
+
+static void ParsePacket()
+{
+    size_t rx_size = RF_Payload_Size(RF_last_protocol);
+    rx_size = rx_size > sizeof(fo_cold.raw) ? sizeof(fo_cold.raw) : rx_size;
 
 #if DEBUG
     Hex2Bin(TxDataTemplate, RxBuffer);
 #endif
 
-    memset(fo.raw, 0, sizeof(fo.raw));
-    memcpy(fo.raw, RxBuffer, rx_size);
-
     if (settings->nmea_p) {
       StdOut.print(F("$PSRFI,"));
       StdOut.print((unsigned long) now()); StdOut.print(F(","));
-      StdOut.print(Bin2Hex(fo.raw, rx_size)); StdOut.print(F(","));
+      StdOut.print(Bin2Hex(RxBuffer, rx_size)); StdOut.print(F(","));
       StdOut.println(RF_last_rssi);
     }
 
@@ -162,57 +833,59 @@ void ParseData()
       return;
     }
 
-    if (protocol_decode && (*protocol_decode)((void *) RxBuffer, &ThisAircraft, &fo)) {
+    /* only those decoders that have a callsign fill it in */
+    memset(fo_cold.callsign, 0, sizeof(fo_cold.callsign));
 
-      int i;
+    if (RF_Decode(RF_last_protocol, (void *) RxBuffer, &ThisAircraft, &fo)) {
 
       fo.rssi = RF_last_rssi;
 
       Traffic_Update(&fo);
 
-      for (i=0; i < MAX_TRACKING_OBJECTS; i++) {
-        if (Container[i].addr == fo.addr) {
-          uint8_t alert_bak = Container[i].alert;
-          Container[i] = fo;
-          Container[i].alert = alert_bak;
-          return;
-        }
-      }
+      ufo_t *fop = Traffic_Lookup(fo.addr, fo.addr_type);
 
-      int max_dist_ndx = 0;
-      int min_level_ndx = 0;
-
-      for (i=0; i < MAX_TRACKING_OBJECTS; i++) {
-        if (now() - Container[i].timestamp > ENTRY_EXPIRATION_TIME) {
-          Container[i] = fo;
-          return;
-        }
-#if !defined(EXCLUDE_TRAFFIC_FILTER_EXTENSION)
-        if  (Container[i].distance > Container[max_dist_ndx].distance)  {
-          max_dist_ndx = i;
-        }
-        if  (Container[i].alarm_level < Container[min_level_ndx].alarm_level)  {
-          min_level_ndx = i;
-        }
-#endif /* EXCLUDE_TRAFFIC_FILTER_EXTENSION */
+      if (fop) {
+        Traffic_Merge(fop, &fo);
+        Traffic_Cold_Fill(fop, rx_size);
+        return;
       }
 
-#if !defined(EXCLUDE_TRAFFIC_FILTER_EXTENSION)
-      if (fo.alarm_level > Container[min_level_ndx].alarm_level) {
-        Container[min_level_ndx] = fo;
+      fop = Traffic_Insert(&fo);
+      if (fop) {
+        Traffic_Cold_Fill(fop, rx_size);
         return;
       }
 
-      if (fo.distance    <  Container[max_dist_ndx].distance &&
-          fo.alarm_level >= Container[max_dist_ndx].alarm_level) {
-        Container[max_dist_ndx] = fo;
-        return;
+#if !defined(EXCLUDE_TRAFFIC_FILTER_EXTENSION)
+      /*
+       * The table is full. Expired entries are taken away by ClearExpired()
+       * on every loop cycle, so only the least relevant target remains to
+       * compete with: lowest alarm level, most distant one among these.
+       */
+      fop = Traffic_Victim();
+
+      if (fo.alarm_level > fop->alarm_level ||
+          (fo.alarm_level == fop->alarm_level && fo.distance < fop->distance)) {
+        fop = Traffic_Replace(fop, &fo);
+        Traffic_Cold_Fill(fop, rx_size);
       }
 #endif /* EXCLUDE_TRAFFIC_FILTER_EXTENSION */
-
     }
 }
 
+/*
+ * Decode the frame RF_Receive() has put into RxBuffer,
+ * then those queued behind it, up to RF_RX_BATCH in total.
+ */
+void ParseData()
+{
+  int n = 0;
+
+  do {
+    ParsePacket();
+  } while (++n < RF_RX_BATCH && RF_Dequeue());
+}
+
 void Traffic_setup()
 {
   switch (settings->alarm)
@@ -236,19 +909,31 @@ void Traffic_setup()
 void Traffic_loop()
 {
   if (isTimeToUpdateTraffic()) {
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
+    Traffic_Geometry_Update();
+
+    for (int i = Traffic_Count() - 1; i >= 0; i--) {
+      ufo_t *fop = Traffic_Entry(i);
 
-      if (Container[i].addr &&
-          (ThisAircraft.timestamp - Container[i].timestamp) <= ENTRY_EXPIRATION_TIME) {
-        if ((ThisAircraft.timestamp - Container[i].timestamp) >= TRAFFIC_VECTOR_UPDATE_INTERVAL) {
-          Traffic_Update(&Container[i]);
+      if (fop->addr &&
+          (ThisAircraft.timestamp - fop->timestamp) <= ENTRY_EXPIRATION_TIME) {
+        if ((ThisAircraft.timestamp - fop->timestamp) >= TRAFFIC_VECTOR_UPDATE_INTERVAL) {
+          uint16_t slot = Traffic_Slots[i];
+
+          fop->distance = Traffic_Geometry.distance[slot];
+          fop->bearing  = Traffic_Geometry.bearing[slot];
+
+          if (Alarm_Level) {
+            fop->alarm_level = (*Alarm_Level)(&ThisAircraft, fop);
+          }
+
+          Traffic_Reorder(fop);
         }
-        if ((Container[i].alert & TRAFFIC_ALERT_SOUND) == 0) {
+        if ((fop->alert & TRAFFIC_ALERT_SOUND) == 0) {
           Sound_Notify();
-          Container[i].alert |= TRAFFIC_ALERT_SOUND;
+          fop->alert |= TRAFFIC_ALERT_SOUND;
         }
       } else {
-        Container[i] = EmptyFO;
+        Traffic_Remove(fop);
       }
     }
 
@@ -258,26 +943,129 @@ void Traffic_loop()
 
 void ClearExpired()
 {
-  for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-    if (Container[i].addr && (ThisAircraft.timestamp - Container[i].timestamp) > ENTRY_EXPIRATION_TIME) {
-      Container[i] = EmptyFO;
+  time_t this_moment = ThisAircraft.timestamp;
+
+  if (this_moment == Traffic_Wheel_Time) {
+    return;
+  }
+
+  time_t tick = Traffic_Wheel_Time + 1;
+
+  /* one full turn of the wheel is enough after a long pause or a time step back */
+  if (this_moment < Traffic_Wheel_Time ||
+      this_moment - Traffic_Wheel_Time > TRAFFIC_WHEEL_SIZE) {
+    tick = this_moment - TRAFFIC_WHEEL_SIZE + 1;
+  }
+
+  for (; tick <= this_moment; tick++) {
+    uint16_t next = Traffic_Wheel[tick & TRAFFIC_WHEEL_MASK];
+
+    while (next) {
+      uint16_t slot = next - 1;
+      next = Traffic_Wheel_Next[slot];
+
+      if (Traffic_Expiry[slot] <= this_moment) {
+        Traffic_Remove(&Container[slot]);
+      }
     }
   }
+
+  Traffic_Wheel_Time = this_moment;
 }
 
 int Traffic_Count()
 {
-  int count = 0;
+  return Traffic_Live_Count;
+}
 
-  for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-    if (Container[i].addr) {
-      count++;
-    }
+#if defined(USE_TRAFFIC_SNAPSHOT)
+
+/*
+ * Two copies of the table behind a latch style sequence counter.
+ * Readers take the copy selected by the counter's low bit, which is
+ * never the one being written, so they neither lock nor wait. A read
+ * is retried only when a publish has completed in the middle of it.
+ */
+static traffic_snapshot_t Traffic_Snapshots[2];
+static std::atomic<uint32_t> Traffic_Snapshot_Seq(0);
+static unsigned long Traffic_Snapshot_Marker = 0;
+
+static void Traffic_Snapshot_Fill(traffic_snapshot_t *s, uint32_t id)
+{
+  s->id        = id;
+  s->time      = now();
+  s->valid_fix = isValidFix();
+  s->ownship   = ThisAircraft;
+  s->count   = Traffic_Live_Count;
+
+  for (int i = 0; i < Traffic_Live_Count; i++) {
+    s->entries[i] = Container[Traffic_Slots[i]];
+    s->cold[i]    = Container_Cold[Traffic_Slots[i]];
+  }
+}
+
+/* To be called by the thread that owns the table, once per main loop cycle */
+void Traffic_Snapshot_Publish()
+{
+  if (millis() - Traffic_Snapshot_Marker < TRAFFIC_SNAPSHOT_INTERVAL_MS) {
+    return;
   }
 
-  return count;
+  uint32_t seq = Traffic_Snapshot_Seq.load(std::memory_order_relaxed);
+
+  /* odd: readers go to copy 1 while copy 0 is being updated */
+  Traffic_Snapshot_Seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  Traffic_Snapshot_Fill(&Traffic_Snapshots[0], seq + 2);
+
+  /* even: readers go to the fresh copy 0 while copy 1 catches up */
+  Traffic_Snapshot_Seq.store(seq + 2, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_release);
+  Traffic_Snapshot_Fill(&Traffic_Snapshots[1], seq + 2);
+
+  Traffic_Snapshot_Marker = millis();
+}
+
+/*
+ * Copy the latest snapshot into dst, unless its id is equal to 'since'
+ * (pass 0 to always get one). Returns false if there is nothing new.
+ * Safe to call from any number of threads.
+ */
+bool Traffic_Snapshot_Read(traffic_snapshot_t *dst, uint32_t since)
+{
+  for (;;) {
+    uint32_t seq = Traffic_Snapshot_Seq.load(std::memory_order_acquire);
+    const traffic_snapshot_t *src = &Traffic_Snapshots[seq & 1];
+
+    uint32_t id = src->id;
+    int count   = src->count;
+
+    count = count < 0 ? 0 :
+           (count > MAX_TRACKING_OBJECTS ? MAX_TRACKING_OBJECTS : count);
+
+    if (id != 0 && id != since) {
+      dst->time      = src->time;
+      dst->valid_fix = src->valid_fix;
+      dst->ownship   = src->ownship;
+      memcpy(dst->entries, src->entries, count * sizeof(ufo_t));
+      memcpy(dst->cold,    src->cold,    count * sizeof(ufo_cold_t));
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (Traffic_Snapshot_Seq.load(std::memory_order_relaxed) == seq) {
+      if (id == 0 || id == since) {
+        return false;
+      }
+      dst->id    = id;
+      dst->count = count;
+      return true;
+    }
+  }
 }
 
+#endif /* USE_TRAFFIC_SNAPSHOT */
+
 int traffic_cmp_by_distance(const void *a, const void *b)
 {
   traffic_by_dist_t *ta = (traffic_by_dist_t *)a;
@@ -287,3 +1075,15 @@ int traffic_cmp_by_distance(const void *a, const void *b)
   if (ta->distance == tb->distance) return  0;
   if (ta->distance <  tb->distance) return -1;
 }
+
+/* higher alarm level first, then closer first */
+int traffic_cmp_by_alarm(const void *a, const void *b)
+{
+  traffic_by_dist_t *ta = (traffic_by_dist_t *)a;
+  traffic_by_dist_t *tb = (traffic_by_dist_t *)b;
+
+  if (ta->fop->alarm_level > tb->fop->alarm_level) return -1;
+  if (ta->fop->alarm_level < tb->fop->alarm_level) return  1;
+
+  return traffic_cmp_by_distance(a, b);
+}
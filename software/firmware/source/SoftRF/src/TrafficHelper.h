@@ -29,11 +29,77 @@
 #define VERTICAL_SEPARATION         300 /* metres */
 #define VERTICAL_VISIBILITY_RANGE   500 /* value from FLARM data port specs */
 
+/* "Legacy" (CPA) alarm method */
+#define ALARM_CPA_HORIZON     19  /* seconds, look-ahead of trajectories */
+#define ALARM_CPA_RADIUS      150 /* metres, horizontal protected zone */
+
 #define TRAFFIC_VECTOR_UPDATE_INTERVAL 2 /* seconds */
 #define TRAFFIC_UPDATE_INTERVAL_MS (TRAFFIC_VECTOR_UPDATE_INTERVAL * 1000)
 #define isTimeToUpdateTraffic() (millis() - UpdateTrafficTimeMarker > \
                                   TRAFFIC_UPDATE_INTERVAL_MS)
 
+/*
+ * Open addressing (linear probing) index over Container[] slots.
+ * Table size is a power of two of at least twice the capacity,
+ * so that probe sequences stay short.
+ */
+#if   MAX_TRACKING_OBJECTS <= 8
+#define TRAFFIC_HASH_BITS     4
+#elif MAX_TRACKING_OBJECTS <= 16
+#define TRAFFIC_HASH_BITS     5
+#elif MAX_TRACKING_OBJECTS <= 32
+#define TRAFFIC_HASH_BITS     6
+#elif MAX_TRACKING_OBJECTS <= 64
+#define TRAFFIC_HASH_BITS     7
+#elif MAX_TRACKING_OBJECTS <= 128
+#define TRAFFIC_HASH_BITS     8
+#elif MAX_TRACKING_OBJECTS <= 256
+#define TRAFFIC_HASH_BITS     9
+#elif MAX_TRACKING_OBJECTS <= 512
+#define TRAFFIC_HASH_BITS     10
+#else
+#error "MAX_TRACKING_OBJECTS is too large"
+#endif
+
+#define TRAFFIC_HASH_SIZE     (1 << TRAFFIC_HASH_BITS)
+#define TRAFFIC_HASH_MASK     (TRAFFIC_HASH_SIZE - 1)
+
+/* Expiry timing wheel, one bucket per second. Has to be a power of two */
+#define TRAFFIC_WHEEL_SIZE    16
+#define TRAFFIC_WHEEL_MASK    (TRAFFIC_WHEEL_SIZE - 1)
+
+/* TinyGPS++ great circle radius, in metres per degree of latitude */
+#define TRAFFIC_METRES_PER_DEGREE   ((float) (6372795.0 * PI / 180.0))
+
+typedef struct traffic_geometry_struct {
+  /* target positions */
+  float latitude  [MAX_TRACKING_OBJECTS];
+  float longitude [MAX_TRACKING_OBJECTS];
+  float altitude  [MAX_TRACKING_OBJECTS];
+
+  /* position relative to own-ship, metres and degrees */
+  float north     [MAX_TRACKING_OBJECTS];
+  float east      [MAX_TRACKING_OBJECTS];
+  float vertical  [MAX_TRACKING_OBJECTS];
+  float distance  [MAX_TRACKING_OBJECTS];
+  float bearing   [MAX_TRACKING_OBJECTS];
+} traffic_geometry_t;
+
+#if defined(USE_TRAFFIC_SNAPSHOT)
+#define TRAFFIC_SNAPSHOT_INTERVAL_MS  250
+
+/* Copy of own-ship and the traffic table, as seen by reader threads */
+typedef struct traffic_snapshot_struct {
+  uint32_t   id;      /* non-zero, changes with every publish */
+  time_t     time;    /* now() at publish, TimeLib is not thread safe */
+  bool       valid_fix;
+  ufo_t      ownship;
+  int        count;
+  ufo_t      entries [MAX_TRACKING_OBJECTS];
+  ufo_cold_t cold    [MAX_TRACKING_OBJECTS];
+} traffic_snapshot_t;
+#endif /* USE_TRAFFIC_SNAPSHOT */
+
 typedef struct traffic_by_dist_struct {
   ufo_t *fop;
   float distance;
@@ -56,9 +122,39 @@ void ClearExpired(void);
 void Traffic_Update(ufo_t *);
 int  Traffic_Count(void);
 
+ufo_t *Traffic_Lookup(uint32_t, uint8_t);
+ufo_t *Traffic_Insert(ufo_t *);
+ufo_t *Traffic_Replace(ufo_t *, ufo_t *);
+void   Traffic_Remove(ufo_t *);
+void   Traffic_Reorder(ufo_t *);
+void   Traffic_Merge(ufo_t *, ufo_t *);
+ufo_t *Traffic_Victim(void);
+
+ufo_cold_t *Traffic_Cold(ufo_t *);
+
+#if defined(USE_TRAFFIC_SNAPSHOT)
+void Traffic_Snapshot_Publish(void);
+bool Traffic_Snapshot_Read(traffic_snapshot_t *, uint32_t);
+#endif /* USE_TRAFFIC_SNAPSHOT */
+
 int  traffic_cmp_by_distance(const void *, const void *);
+int  traffic_cmp_by_alarm(const void *, const void *);
 
 extern ufo_t fo, Container[MAX_TRACKING_OBJECTS], EmptyFO;
+extern ufo_cold_t fo_cold, EmptyFO_Cold;
 extern traffic_by_dist_t traffic_by_dist[MAX_TRACKING_OBJECTS];
 
+extern uint16_t Traffic_Slots[MAX_TRACKING_OBJECTS];
+extern traffic_geometry_t Traffic_Geometry;
+
+/*
+ * n-th live entry of the traffic table, 0 <= n < Traffic_Count().
+ * Traffic_Remove() moves the last live entry into the freed position,
+ * so walk the table backwards when entries are removed on the go.
+ */
+static inline ufo_t *Traffic_Entry(int n)
+{
+  return &Container[Traffic_Slots[n]];
+}
+
 #endif /* TRAFFICHELPER_H */
@@ -62,7 +62,7 @@ typedef struct Settings {
     int8_t   freq_corr; /* +/-, kHz */
     uint32_t  aircraftID;
     uint8_t  idType;
-    uint8_t  resvd11;
+    uint8_t  rf_protocol2; /* of secondary radio */
     uint8_t  resvd12;
     uint8_t  resvd13;
     uint8_t  resvd14;
@@ -43,6 +43,7 @@
 
 unsigned long GNSSTimeSyncMarker = 0;
 volatile unsigned long PPS_TimeMarker = 0;
+volatile unsigned long PPS_TimeMarker_us = 0;
 
 double Heading = 0.0;
 double Prev_Heading = 0.0;
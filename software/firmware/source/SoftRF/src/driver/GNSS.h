@@ -65,10 +65,11 @@ int LookupSeparation (float, float);
 
 extern TinyGPSPlus gnss;
 extern volatile unsigned long PPS_TimeMarker;
+extern volatile unsigned long PPS_TimeMarker_us;
 extern const char *GNSS_name[];
 
 extern volatile double Rotation_Rate;
 extern volatile unsigned int turning;
 extern volatile unsigned int flying;
 
-#endif /* GNSSHELPER_H */
\ No newline at end of file
+#endif /* GNSSHELPER_H */
\ No newline at end of file
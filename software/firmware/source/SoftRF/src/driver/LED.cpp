@@ -161,12 +161,13 @@ void LED_DisplayTraffic() {
   if (SOC_GPIO_PIN_LED != SOC_UNUSED_PIN && settings->pointer != LED_OFF) {
     LED_Clear_noflush();
 
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
+    for (int i=0; i < Traffic_Count(); i++) {
+      ufo_t *fop = Traffic_Entry(i);
 
-      if (Container[i].addr && (now() - Container[i].timestamp) <= LED_EXPIRATION_TIME) {
+      if (fop->addr && (now() - fop->timestamp) <= LED_EXPIRATION_TIME) {
 
-        bearing  = (int) Container[i].bearing;
-        distance = (int) Container[i].distance;
+        bearing  = (int) fop->bearing;
+        distance = (int) fop->distance;
 
         if (settings->pointer == DIRECTION_TRACK_UP) {
           bearing = (360 + bearing - (int)ThisAircraft.course) % 360;
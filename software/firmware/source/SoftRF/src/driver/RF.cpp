@@ -21,6 +21,7 @@
 
 #include "RF.h"
 #include "../system/SoC.h"
+#include "../system/Time.h"
 #include "EEPROM.h"
 #include "Battery.h"
 #include "../ui/Web.h"
@@ -28,6 +29,7 @@
 #include "../protocol/data/MAVLink.h"
 #endif /* EXCLUDE_MAVLINK */
 #include <fec.h>
+#include <manchester.h>
 
 #if LOGGER_IS_ENABLED
 #include "../system/Log.h"
@@ -35,21 +37,44 @@
 
 byte RxBuffer[MAX_PKT_SIZE] __attribute__((aligned(sizeof(uint32_t))));
 
-unsigned long TxTimeMarker = 0;
+uint64_t TxTimeMarker = 0;
 byte TxBuffer[MAX_PKT_SIZE] __attribute__((aligned(sizeof(uint32_t))));
 
 uint32_t tx_packets_counter = 0;
+uint32_t tx_packets_lost    = 0;
 uint32_t rx_packets_counter = 0;
+uint32_t rx_packets_lost    = 0;
+uint32_t rx_packets_corrected = 0;
+uint32_t rx_bits_corrected    = 0;
+
+static LDPC_Decoder RF_LDPC;
+
+/*
+ * Single producer, single consumer ring of received frames.
+ * Drivers put frames in from their RX interrupt, callback or polling
+ * code, RF_Dequeue() takes them out into RxBuffer for decoding.
+ */
+static rf_rx_packet_t RF_RxQueue[RF_RX_QUEUE_SIZE];
+static volatile uint8_t RF_RxQueue_Head = 0;
+static volatile uint8_t RF_RxQueue_Tail = 0;
+static uint8_t RF_current_channel = 0;
 
 int8_t RF_last_rssi = 0;
+uint8_t RF_last_protocol = RF_PROTOCOL_NONE;
 
 FreqPlan RF_FreqPlan;
 static bool RF_ready = false;
 
 static size_t RF_tx_size = 0;
-static long TxRandomValue = 0;
+static long TxRandomValue = 0;  // usec after TxTimeMarker
 
-const rfchip_ops_t *rf_chip = NULL;
+static void RF_Airtime_Charge(size_t);
+static void RF_Tx_Done(bool);
+
+const rfchip_ops_t *rf_chip = NULL;  /* primary radio, the one that transmits */
+rf_radio_t RF_Radios[RF_MAX_RADIOS];
+uint8_t RF_Radio_Count = 0;
+static bool RF_Hopping = false;      /* any of the radios hops */
 bool RF_SX12XX_RST_is_connected = true;
 
 size_t (*protocol_encode)(void *, ufo_t *);
@@ -59,7 +84,7 @@ static bool nrf905_probe(void);
 static void nrf905_setup(void);
 static void nrf905_channel(uint8_t);
 static bool nrf905_receive(void);
-static void nrf905_transmit(void);
+static bool nrf905_transmit(void);
 static void nrf905_shutdown(void);
 
 static bool sx1276_probe(void);
@@ -67,28 +92,28 @@ static bool sx1262_probe(void);
 static void sx12xx_setup(void);
 static void sx12xx_channel(uint8_t);
 static bool sx12xx_receive(void);
-static void sx12xx_transmit(void);
+static bool sx12xx_transmit(void);
 static void sx12xx_shutdown(void);
 
 static bool uatm_probe(void);
 static void uatm_setup(void);
 static void uatm_channel(uint8_t);
 static bool uatm_receive(void);
-static void uatm_transmit(void);
+static bool uatm_transmit(void);
 static void uatm_shutdown(void);
 
 static bool cc13xx_probe(void);
 static void cc13xx_setup(void);
 static void cc13xx_channel(uint8_t);
 static bool cc13xx_receive(void);
-static void cc13xx_transmit(void);
+static bool cc13xx_transmit(void);
 static void cc13xx_shutdown(void);
 
 static bool ognrf_probe(void);
 static void ognrf_setup(void);
 static void ognrf_channel(uint8_t);
 static bool ognrf_receive(void);
-static void ognrf_transmit(void);
+static bool ognrf_transmit(void);
 static void ognrf_shutdown(void);
 
 #if !defined(EXCLUDE_NRF905)
@@ -155,6 +180,11 @@ const rfchip_ops_t cc13xx_ops = {
 
 #define vTaskDelay  delay
 
+#if defined(HAL_SPI_BURST)
+/* RFM register and FIFO access as whole SPI blocks */
+#define USE_BLOCK_SPI
+#endif /* HAL_SPI_BURST */
+
 #if defined(WITH_SI4X32)
 #include <rf/si4x32/rfm.h>
 #else
@@ -194,15 +224,60 @@ uint8_t parity(uint32_t x) {
     return (parity % 2);
 }
  
+static bool RF_Protocol_Hops(uint8_t protocol)
+{
+  return protocol == RF_PROTOCOL_LEGACY || protocol == RF_PROTOCOL_OGNTP;
+}
+
+static void RF_Radio_Add(const rfchip_ops_t *ops)
+{
+  if (RF_Radio_Count < RF_MAX_RADIOS) {
+    RF_Radios[RF_Radio_Count].ops      = ops;
+    RF_Radios[RF_Radio_Count].protocol = RF_PROTOCOL_NONE;
+    RF_Radios[RF_Radio_Count].channel  = 0;
+    RF_Radio_Count++;
+  }
+}
+
+/*
+ * Drivers set themselves up after settings->rf_protocol and rf_chip,
+ * and leave their codec in protocol_encode/decode.
+ * Secondary radios go first, so that the primary one has the last word.
+ */
+static void RF_Radio_Setup(void)
+{
+  uint8_t protocol = settings->rf_protocol;
+
+  RF_Hopping = false;
+
+  for (int i = RF_Radio_Count - 1; i >= 0; i--) {
+    rf_radio_t *radio = &RF_Radios[i];
+
+    settings->rf_protocol = (i == 0 ? protocol : settings->rf_protocol2);
+    rf_chip = radio->ops;
+    rf_chip->setup();
+
+    /* some RFICs enforce a protocol of their own */
+    radio->protocol = settings->rf_protocol;
+    radio->encode   = protocol_encode;
+    radio->decode   = protocol_decode;
+
+    RF_Hopping |= RF_Protocol_Hops(radio->protocol);
+  }
+}
+
 byte RF_setup(void)
 {
 
   if (rf_chip == NULL) {
+    /* look for a secondary radio only when it has a protocol to work with */
+    uint8_t limit = settings->rf_protocol2 == RF_PROTOCOL_NONE ? 1 : RF_MAX_RADIOS;
+
 #if !defined(USE_OGN_RF_DRIVER)
 #if !defined(EXCLUDE_SX12XX)
 #if !defined(EXCLUDE_SX1276)
     if (sx1276_ops.probe()) {
-      rf_chip = &sx1276_ops;
+      RF_Radio_Add(&sx1276_ops);
 #else
     if (false) {
 #endif
@@ -211,39 +286,43 @@ byte RF_setup(void)
       SX12XX_LL = &sx127x_ll_ops;
 #endif
     } else if (sx1262_ops.probe()) {
-      rf_chip = &sx1262_ops;
+      RF_Radio_Add(&sx1262_ops);
       SX12XX_LL = &sx126x_ll_ops;
 #endif /* USE_BASICMAC */
-#else
-    if (false) {
+    }
 #endif /* EXCLUDE_SX12XX */
 #if !defined(EXCLUDE_NRF905)
-    } else if (nrf905_ops.probe()) {
-      rf_chip = &nrf905_ops;
+    if (RF_Radio_Count < limit && nrf905_ops.probe()) {
+      RF_Radio_Add(&nrf905_ops);
+    }
 #endif /* EXCLUDE_NRF905 */
 #if !defined(EXCLUDE_UATM)
-    } else if (uatm_ops.probe()) {
-      rf_chip = &uatm_ops;
+    if (RF_Radio_Count < limit && uatm_ops.probe()) {
+      RF_Radio_Add(&uatm_ops);
+    }
 #endif /* EXCLUDE_UATM */
 #if !defined(EXCLUDE_CC13XX)
-    } else if (cc13xx_ops.probe()) {
-      rf_chip = &cc13xx_ops;
-#endif /* EXCLUDE_CC13XX */
+    if (RF_Radio_Count < limit && cc13xx_ops.probe()) {
+      RF_Radio_Add(&cc13xx_ops);
     }
-    if (rf_chip && rf_chip->name) {
-      Serial.print(rf_chip->name);
+#endif /* EXCLUDE_CC13XX */
+    for (uint8_t i = 0; i < RF_Radio_Count; i++) {
+      Serial.print(RF_Radios[i].ops->name);
       Serial.println(F(" RFIC is detected."));
-    } else {
+    }
+    if (RF_Radio_Count == 0) {
       Serial.println(F("WARNING! None of supported RFICs is detected!"));
     }
 #else /* USE_OGN_RF_DRIVER */
     if (ognrf_ops.probe()) {
-      rf_chip = &ognrf_ops;
+      RF_Radio_Add(&ognrf_ops);
       Serial.println(F("OGN_DRV: RFIC is detected."));
     } else {
       Serial.println(F("WARNING! RFIC is NOT detected."));
     }
 #endif /* USE_OGN_RF_DRIVER */
+
+    rf_chip = RF_Radio_Count ? RF_Radios[0].ops : NULL;
   }
 
   /* "AUTO" freq. will set the plan upon very first valid GNSS fix */
@@ -261,7 +340,7 @@ byte RF_setup(void)
   }
 
   if (rf_chip) {
-    rf_chip->setup();
+    RF_Radio_Setup();
     return rf_chip->type;
   } else {
     return RF_IC_NONE;
@@ -276,17 +355,118 @@ byte RF_setup(void)
 
 extern int status_LED;  // LEDHelper
 
-static long TimeReference =   0;  // Hop reference timing
-static long TimeReference_2 = 0; 
-static long Now_millis =      0;
-static long prev_TimeCommit = 0;
+static int64_t TimeReference =   0;  // Hop reference timing, usec
+static int64_t TimeReference_2 = 0; 
+static int64_t Now_micros =      0;
+static int64_t prev_TimeCommit = 0;
 uint8_t Slot = 0;
 time_t slotTime = 0;
 
+/* GNSS date/time last converted by makeTime() */
+static uint32_t RF_gnss_date  = 0;
+static uint32_t RF_gnss_time  = 0;
+static time_t   RF_gnss_epoch = 0;
+
+/* channels for [OGN][second - base][slot], refilled when time leaves the window */
+static uint8_t  RF_HopCache[2][RF_HOP_CACHE_SECONDS][2];
+static time_t   RF_HopCache_Base  = 0;
+static uint8_t  RF_HopCache_Plan  = 0;
+static bool     RF_HopCache_Valid = false;
+
+static void RF_HopCache_Fill(time_t Base)
+{
+  for (uint8_t sec = 0; sec < RF_HOP_CACHE_SECONDS; sec++) {
+    for (uint8_t slot = 0; slot < 2; slot++) {
+      RF_HopCache[0][sec][slot] = RF_FreqPlan.getChannel(Base + sec, slot, 0);
+      RF_HopCache[1][sec][slot] = RF_FreqPlan.getChannel(Base + sec, slot, 1);
+    }
+  }
+
+  RF_HopCache_Base  = Base;
+  RF_HopCache_Plan  = RF_FreqPlan.Plan;
+  RF_HopCache_Valid = true;
+}
+
+static time_t RF_GNSS_Epoch()
+{
+  uint32_t date = gnss.date.value();
+  uint32_t time = gnss.time.value();
+
+  if (date != RF_gnss_date || time != RF_gnss_time) {
+    tmElements_t tm;
+
+    int yr = gnss.date.year();
+    if( yr > 99)
+        yr = yr - 1970;
+    else
+        yr += 30;
+    tm.Year = yr;
+    tm.Month = gnss.date.month();
+    tm.Day = gnss.date.day();
+    tm.Hour = gnss.time.hour();
+    tm.Minute = gnss.time.minute();
+    tm.Second = gnss.time.second();
+
+    RF_gnss_epoch = makeTime(tm);
+    RF_gnss_date  = date;
+    RF_gnss_time  = time;
+  }
+
+  return RF_gnss_epoch;
+}
+
+/*
+ * Tunes the radios whose protocol hops ('hopping') or the ones which
+ * do not, the latter always on the slot 0 channel.
+ */
+static void RF_Tune(time_t Time, bool hopping)
+{
+  if (!RF_HopCache_Valid                     ||
+      RF_HopCache_Plan != RF_FreqPlan.Plan   ||
+      Time < RF_HopCache_Base                ||
+      Time - RF_HopCache_Base >= RF_HOP_CACHE_SECONDS) {
+    RF_HopCache_Fill(Time);
+  }
+
+  uint8_t slot = hopping ? (Slot & 1) : 0;
+  uint8_t OGN;
+
+  if (RF_Protocol_Hops(settings->rf_protocol) == hopping) {
+    OGN = (settings->rf_protocol == RF_PROTOCOL_OGNTP ? 1 : 0);
+    uint8_t chan = RF_HopCache[OGN][Time - RF_HopCache_Base][slot];
+
+    // HOP Testing - time and channel
+    //Serial.printf("Time: %d, %d\r\n", Time,chan);
+
+#if DEBUG
+    Serial.print("Plan: "); Serial.println(RF_FreqPlan.Plan);
+    Serial.print("Slot: "); Serial.println(slot);
+    Serial.print("OGN: "); Serial.println(OGN);
+    Serial.print("Channel: "); Serial.println(chan);
+#endif
+
+    RF_current_channel = chan;
+  }
+
+  if (RF_ready) {
+    for (uint8_t i = 0; i < RF_Radio_Count; i++) {
+      rf_radio_t *radio = &RF_Radios[i];
+
+      if (RF_Protocol_Hops(radio->protocol) != hopping) {
+        continue;
+      }
+
+      OGN = (radio->protocol == RF_PROTOCOL_OGNTP ? 1 : 0);
+      radio->channel = RF_HopCache[OGN][Time - RF_HopCache_Base][slot];
+      radio->ops->channel(radio->channel);
+    }
+  }
+}
+
 void RF_SetChannel(void)
 {
-  tmElements_t tm;
   time_t Time;
+  bool fixed_tuned = false;
 
   switch (settings->mode)
   {
@@ -300,110 +480,91 @@ void RF_SetChannel(void)
 #endif /* EXCLUDE_MAVLINK */
   case SOFTRF_MODE_NORMAL:
   default:
-    unsigned long pps_btime_ms = SoC->get_PPS_TimeMarker();
-//    unsigned long time_corr_pos = 0;
-    unsigned long time_corr_neg = 0;
-    unsigned long timeAge = 0;
-    unsigned long lastCommitTime = (Now_millis = millis()) - (timeAge = gnss.time.age());
+    bool pps_locked = Time_PPS_locked();
+    int64_t pps_btime_us = 0;
+//    int64_t time_corr_pos = 0;
+    int64_t time_corr_neg = 0;
+    int64_t timeAge = 0;
+    int64_t lastCommitTime = (Now_micros = Time_micros64()) -
+                             (timeAge = gnss.time.age() * 1000LL);
 	
     // HOP Testing - NMEA sentence time commit
-    //Serial.printf("Commit: %d, %d, %d\r\n", lastCommitTime, prev_TimeCommit, pps_btime_ms);
+    //Serial.printf("Commit: %d, %d, %d\r\n", lastCommitTime, prev_TimeCommit, pps_btime_us);
 	
+    if (pps_locked) {
+      // disciplined PPS: the edge before the NMEA commit labels the second,
+      // so it does not matter whether GGA or RMC committed the time
+      pps_btime_us  = Time_PPS_edge(Now_micros);
+      time_corr_neg = lastCommitTime - Time_PPS_edge(lastCommitTime);
+    } else {
 	// Time could be in GGA or RMC. For consistency must pick only first one
 	// problem is that the second commit is 450 msec after the first or only 550 before next !
 	// not needed if PPS is available
-	if (lastCommitTime - prev_TimeCommit < 500) {
+	if (lastCommitTime - prev_TimeCommit < 500000) {
 	  lastCommitTime = prev_TimeCommit;
-      timeAge = Now_millis - lastCommitTime;
+      timeAge = Now_micros - lastCommitTime;
 	} else {
 	  prev_TimeCommit = lastCommitTime;
 	}
-    
-    // if PPS available, reference time is PPS relative for accuracy
-    if (pps_btime_ms) {
-      // calculate delta time from millis() to PPS reference
-      if (pps_btime_ms <= lastCommitTime) {
-        time_corr_neg = (lastCommitTime - pps_btime_ms) % 1000;
-      } else {
-        time_corr_neg = 1000 - ((pps_btime_ms - lastCommitTime) % 1000);
-      }
-    } else {  // no PPS, approximate reference delay
-      time_corr_neg = DELAY_PPS_GPSTIME;
+
+    // no disciplined PPS (yet), approximate reference delay
+      time_corr_neg = DELAY_PPS_GPSTIME * 1000;
     }
 
-    // only frequency hop with legacy and OGN protocols
-    switch (settings->rf_protocol) {
-      case RF_PROTOCOL_LEGACY: 
-      case RF_PROTOCOL_OGNTP: 
-        if ((Now_millis - TimeReference) >= 1000) {   
-	      if (pps_btime_ms) {
-	        TimeReference = pps_btime_ms +SLOT1_START -SLOT1_ADVANCE -0; // allow for latency ?
+    // time right now is (latest time from GPS, converted once per fix):
+    Time = RF_GNSS_Epoch() + (timeAge + time_corr_neg)/ 1000000;
+
+    // radios which do not hop stay tuned whatever the slot timing is
+    RF_Tune(Time, false);
+    fixed_tuned = true;
+
+    // only frequency hop with legacy and OGN protocols,
+    // Tx slots are only of concern to the primary radio
+    bool tx_slots = RF_Protocol_Hops(settings->rf_protocol);
+
+    if (RF_Hopping) {
+        if ((Now_micros - TimeReference) >= 1000000) {   
+	      if (pps_locked) {
+	        TimeReference = pps_btime_us +(SLOT1_START -SLOT1_ADVANCE -0) * 1000; // allow for latency ?
 		  } else {
-            TimeReference = lastCommitTime -time_corr_neg +SLOT1_START -SLOT1_ADVANCE;
+            TimeReference = lastCommitTime -time_corr_neg +(SLOT1_START -SLOT1_ADVANCE) * 1000;
 		  }
           Slot = 0;
-          if ((Now_millis - TimeReference) >= 1000) { // has PPS stopped ?
-		    TxTimeMarker = Now_millis;                // if so no Tx
+          if ((Now_micros - TimeReference) >= 1000000) { // is time stale ?
+		    if (tx_slots) TxTimeMarker = Now_micros;     // if so no Tx
 			return;
-		  } else {
+		  } else if (tx_slots) {
             TxTimeMarker = TimeReference;
+            TxRandomValue = SoC->random(0, (SLOT_DURATION -10) * 1000) +SLOT1_ADVANCE * 1000;  // allow some margin
 		  }
-          TxRandomValue = SoC->random(0, SLOT_DURATION -10) +SLOT1_ADVANCE;  // allow some margin
         } else {
-          if ((Now_millis - TimeReference_2) >= 1000) {
-	        TimeReference_2 = TimeReference +SLOT_DURATION +SLOT1_ADVANCE;
+          if ((Now_micros - TimeReference_2) >= 1000000) {
+	        TimeReference_2 = TimeReference +(SLOT_DURATION +SLOT1_ADVANCE) * 1000;
             Slot = 1;
-            TxTimeMarker = TimeReference_2;
-            TxRandomValue = SoC->random(10, SLOT_DURATION -0);  //  allow some margin
+            if (tx_slots) {
+              TxTimeMarker = TimeReference_2;
+              TxRandomValue = SoC->random(10 * 1000, (SLOT_DURATION -0) * 1000);  //  allow some margin
+            }
           } else {
  	        return;	  
           }
 	    }
-        break;
-      default:
+    } else {
         /* FANET uses 868.2 MHz. Bandwidth is 250kHz  */
         Slot = 0;
-        break;
     }
 
     // HOP Testing - slot timing 400 and 800 msec after PPS
-    //Serial.printf("Timing: %d, %d, %d, %d, %d, %d, %d\r\n", Now_millis, pps_btime_ms, timeAge, time_corr_neg, TimeReference, TxRandomValue, Slot);
+    //Serial.printf("Timing: %d, %d, %d, %d, %d, %d, %d\r\n", Now_micros, pps_btime_us, timeAge, time_corr_neg, TimeReference, TxRandomValue, Slot);
 
-    // latest time from GPS
-    int yr = gnss.date.year();
-    if( yr > 99)
-        yr = yr - 1970;
-    else
-        yr += 30;
-    tm.Year = yr;
-    tm.Month = gnss.date.month();
-    tm.Day = gnss.date.day();
-    tm.Hour = gnss.time.hour();
-    tm.Minute = gnss.time.minute();
-    tm.Second = gnss.time.second();
-
-    // time right now is:
-    slotTime = Time = makeTime(tm) + (timeAge + time_corr_neg)/ 1000;
+    slotTime = Time;
     break;
   }
 
-  uint8_t OGN = (settings->rf_protocol == RF_PROTOCOL_OGNTP ? 1 : 0);
-
-  uint8_t chan = RF_FreqPlan.getChannel(Time, Slot, OGN);
-
-  // HOP Testing - time and channel
-  //Serial.printf("Time: %d, %d\r\n", Time,chan);
-
-#if DEBUG
-  Serial.print("Plan: "); Serial.println(RF_FreqPlan.Plan);
-  Serial.print("Slot: "); Serial.println(Slot);
-  Serial.print("OGN: "); Serial.println(OGN);
-  Serial.print("Channel: "); Serial.println(chan);
-#endif
-
-  if (RF_ready && rf_chip) {
-    rf_chip->channel(chan);
+  if (!fixed_tuned) {
+    RF_Tune(Time, false);
   }
+  RF_Tune(Time, true);
 }
 
 void RF_loop()
@@ -420,6 +581,8 @@ void RF_loop()
     }
   }
 
+  Time_loop();
+
   if (RF_ready) {
     RF_SetChannel();
   }
@@ -434,7 +597,7 @@ size_t RF_Encode(ufo_t *fop)
       return size;
     }
 
-    if ((millis() - TxTimeMarker) > TxRandomValue) {
+    if ((int64_t) (Time_micros64() - TxTimeMarker) > TxRandomValue) {
       switch (settings->rf_protocol) {
         case RF_PROTOCOL_LEGACY: 
         case RF_PROTOCOL_OGNTP: 
@@ -456,11 +619,19 @@ bool RF_Transmit(size_t size, bool wait)
       return true;
     }
 
-    if (!wait || (millis() - TxTimeMarker) > TxRandomValue) {
+    if (!wait || (int64_t) (Time_micros64() - TxTimeMarker) > TxRandomValue) {
+
+      if (!RF_Airtime_Available(size, RF_TX_PRIORITY_OWN)) {
+        return false;
+      }
 
       time_t timestamp = now();
 
-      rf_chip->transmit();
+      /* the chip may refuse while it is still busy with a frame */
+      if (!rf_chip->transmit()) {
+        return false;
+      }
+      RF_Airtime_Charge(size);
 
       if (settings->nmea_p) {
         StdOut.print(F("$PSRFO,"));
@@ -475,8 +646,8 @@ bool RF_Transmit(size_t size, bool wait)
       switch (settings->rf_protocol) {
         case RF_PROTOCOL_LEGACY: 
         case RF_PROTOCOL_OGNTP: 
-          TxRandomValue = 2000;   // HOP - stop any re-trigger for now until next channel change
-          TxTimeMarker = millis();
+          TxRandomValue = 2000000; // HOP - stop any re-trigger for now until next channel change
+          TxTimeMarker = Time_micros64();
           break;
       default:
         TxRandomValue = (
@@ -484,14 +655,14 @@ bool RF_Transmit(size_t size, bool wait)
           LMIC.protocol ?
           SoC->random(LMIC.protocol->tx_interval_min, LMIC.protocol->tx_interval_max) :
 #endif
-          SoC->random(LEGACY_TX_INTERVAL_MIN, LEGACY_TX_INTERVAL_MAX));
+          SoC->random(LEGACY_TX_INTERVAL_MIN, LEGACY_TX_INTERVAL_MAX)) * 1000;
 
-        TxTimeMarker = millis();
+        TxTimeMarker = Time_micros64();
         break;
       }
       
       // HOP testing - transmit time
-      //Serial.printf("Tx: %d, %d, %d\r\n", millis(), TxTimeMarker, TxRandomValue);
+      //Serial.printf("Tx: %d, %d, %d\r\n", Time_micros64(), TxTimeMarker, TxRandomValue);
 
       return true;
     }
@@ -499,38 +670,405 @@ bool RF_Transmit(size_t size, bool wait)
   return false;
 }
 
-bool RF_Receive(void)
+/* completion report of transmitters that finish asynchronously */
+static void RF_Tx_Done(bool success)
+{
+  if (!success) {
+    tx_packets_lost++;
+  }
+}
+
+/* Frame check sequence of a frame body as per protocol descriptor */
+static uint16_t RF_Checksum(const rf_proto_desc_t *proto, const byte *buf, size_t size)
+{
+  switch (proto->crc_type)
+  {
+  case RF_CHECKSUM_TYPE_GALLAGER:
+  case RF_CHECKSUM_TYPE_NONE:
+    return 0;
+  case RF_CHECKSUM_TYPE_CRC8_107:
+    return crc8_107(CRC8_107_SEED, buf, size);
+  case RF_CHECKSUM_TYPE_CCITT_0000:
+    return crc16_ccitt(CRC16_CCITT_0000_SEED, buf, size);
+  case RF_CHECKSUM_TYPE_CCITT_FFFF:
+  default:
+    /* take in account NRF905/FLARM "address" bytes */
+    return crc16_ccitt(proto->type == RF_PROTOCOL_LEGACY ?
+                       CRC16_LEGACY_SEED : CRC16_CCITT_FFFF_SEED, buf, size);
+  }
+}
+
+/*
+ * Frame decoders. A single pass over the frame as it came off the air
+ * does Manchester decoding, the checksum and dewhitening. There is one
+ * instance per whitening and checksum type, picked when the radio is
+ * set up, so that nothing is switched on per byte. The checksum covers
+ * the bytes after Manchester decoding and before dewhitening.
+ * Returns true when the frame is intact, decoded bytes are in out.
+ */
+template <uint8_t WHITENING, uint8_t CRC_TYPE>
+static bool RF_Decode_Frame(const rf_proto_desc_t *proto, const byte *in,
+                            size_t size, byte *out, byte *err)
+{
+  uint16_t crc = RF_Checksum(proto, NULL, 0); /* seed value */
+  size_t   end = size + proto->crc_size;
+  byte     b;
+
+  for (size_t j = 0; j < end; j++) {
+    if (WHITENING == RF_WHITENING_MANCHESTER) {
+      uint8_t hi = pgm_read_byte(&ManchesterDecode[in[2*j]]);
+      uint8_t lo = pgm_read_byte(&ManchesterDecode[in[2*j + 1]]);
+      b      = (hi << 4)   | (lo & 0x0F);
+      err[j] = (hi & 0xF0) | (lo >> 4);
+    } else {
+      b = in[j];
+    }
+
+    if (j < size) {
+      if (CRC_TYPE == RF_CHECKSUM_TYPE_CRC8_107) {
+        crc = crc8_107_update(crc, b);
+      } else if (CRC_TYPE != RF_CHECKSUM_TYPE_NONE &&
+                 CRC_TYPE != RF_CHECKSUM_TYPE_GALLAGER) {
+        crc = crc16_ccitt_update(crc, b);
+      }
+      if (WHITENING == RF_WHITENING_NICERF) {
+        b ^= pgm_read_byte(&whitening_pattern[j]);
+      }
+    }
+
+    out[j] = b;
+  }
+
+  switch (CRC_TYPE)
+  {
+  case RF_CHECKSUM_TYPE_NONE:
+    return true;
+  case RF_CHECKSUM_TYPE_GALLAGER:
+    return LDPC_Check((uint8_t *) out) == 0 ||
+           RF_LDPC_Decode(out, WHITENING == RF_WHITENING_MANCHESTER ? err : NULL) >= 0;
+  case RF_CHECKSUM_TYPE_CRC8_107:
+    return out[size] == (uint8_t) crc;
+  default:
+    return ((out[size] << 8) | out[size + 1]) == crc;
+  }
+}
+
+typedef bool (*rf_frame_decode_t)(const rf_proto_desc_t *, const byte *,
+                                  size_t, byte *, byte *);
+
+template <uint8_t WHITENING>
+static rf_frame_decode_t RF_Frame_Decoder(uint8_t crc_type)
+{
+  switch (crc_type)
+  {
+  case RF_CHECKSUM_TYPE_NONE:
+    return &RF_Decode_Frame<WHITENING, RF_CHECKSUM_TYPE_NONE>;
+  case RF_CHECKSUM_TYPE_GALLAGER:
+    return &RF_Decode_Frame<WHITENING, RF_CHECKSUM_TYPE_GALLAGER>;
+  case RF_CHECKSUM_TYPE_CRC8_107:
+    return &RF_Decode_Frame<WHITENING, RF_CHECKSUM_TYPE_CRC8_107>;
+  default:
+    /* CCITT flavours differ in the seed only */
+    return &RF_Decode_Frame<WHITENING, RF_CHECKSUM_TYPE_CCITT_FFFF>;
+  }
+}
+
+/* hw_manchester is set for ICs that strip Manchester code on their own */
+static rf_frame_decode_t RF_Frame_Decoder(const rf_proto_desc_t *proto,
+                                          bool hw_manchester)
+{
+  switch (proto->whitening)
+  {
+  case RF_WHITENING_NICERF:
+    return RF_Frame_Decoder<RF_WHITENING_NICERF>(proto->crc_type);
+  case RF_WHITENING_MANCHESTER:
+    if (!hw_manchester) {
+      return RF_Frame_Decoder<RF_WHITENING_MANCHESTER>(proto->crc_type);
+    }
+    return RF_Frame_Decoder<RF_WHITENING_NONE>(proto->crc_type);
+  case RF_WHITENING_NONE:
+  default:
+    return RF_Frame_Decoder<RF_WHITENING_NONE>(proto->crc_type);
+  }
+}
+
+static rf_frame_decode_t RF_FrameDecode =
+  &RF_Decode_Frame<RF_WHITENING_NONE, RF_CHECKSUM_TYPE_NONE>;
+
+/* Channel the radio that receives given protocol is tuned to */
+static uint8_t RF_Radio_Channel(uint8_t protocol)
+{
+  for (uint8_t i = 1; i < RF_Radio_Count; i++) {
+    if (RF_Radios[i].protocol == protocol) {
+      return RF_Radios[i].channel;
+    }
+  }
+
+  return RF_current_channel;
+}
+
+/* Queue a received frame, drop it when the ring is full */
+static void RF_Enqueue(const byte *payload, size_t size, int8_t rssi, uint8_t protocol)
+{
+  uint8_t head = RF_RxQueue_Head;
+
+  if ((uint8_t) (head - RF_RxQueue_Tail) >= RF_RX_QUEUE_SIZE) {
+    rx_packets_lost++;
+    return;
+  }
+
+  rf_rx_packet_t *pkt = &RF_RxQueue[head & RF_RX_QUEUE_MASK];
+
+  if (size > sizeof(pkt->payload)) {
+    size = sizeof(pkt->payload);
+  }
+
+  memcpy(pkt->payload, payload, size);
+  memset(pkt->payload + size, 0, sizeof(pkt->payload) - size);
+
+  pkt->time     = slotTime;
+  pkt->ms       = millis();
+  pkt->rssi     = rssi;
+  pkt->channel  = RF_Radio_Channel(protocol);
+  pkt->protocol = protocol;
+  pkt->size     = size;
+
+  /* frame has to be in place before the consumer can see it */
+  __sync_synchronize();
+  RF_RxQueue_Head = head + 1;
+
+  rx_packets_counter++;
+}
+
+/*
+ * Recover an OGNTP frame that fails its parity checks.
+ * Bits flagged in Err (invalid Manchester pairs) enter the decoder as
+ * erasures, the rest as hard decisions. Err may be NULL when the radio
+ * does Manchester decoding in hardware. The frame is corrected in place.
+ * Returns number of flipped bits or -1 when the frame is not recoverable.
+ */
+int RF_LDPC_Decode(uint8_t *Data, const uint8_t *Err)
+{
+  uint8_t Erasures[LDPC_Decoder::CodeBytes];
+  uint8_t Corrected[LDPC_Decoder::CodeBytes];
+  int8_t  Check = 1;
+  int     bits  = 0;
+
+  if (Err) {
+    memcpy(Erasures, Err, sizeof(Erasures));
+  } else {
+    memset(Erasures, 0, sizeof(Erasures));
+  }
+
+  RF_LDPC.Input(Data, Erasures);
+  for (uint8_t Iter = 0; Check && Iter < OGNTP_LDPC_ITERATIONS; Iter++) {
+    Check = RF_LDPC.ProcessChecks();
+  }
+
+  if (Check) {
+    return -1;
+  }
+
+  RF_LDPC.Output(Corrected);
+  for (uint8_t i = 0; i < sizeof(Corrected); i++) {
+    bits += Count1s((uint8_t) (Data[i] ^ Corrected[i]));
+  }
+  memcpy(Data, Corrected, sizeof(Corrected));
+
+  rx_packets_corrected++;
+  rx_bits_corrected += bits;
+
+  return bits;
+}
+
+/* Move the oldest queued frame into RxBuffer */
+bool RF_Dequeue(void)
+{
+  uint8_t tail = RF_RxQueue_Tail;
+
+  if (tail == RF_RxQueue_Head) {
+    return false;
+  }
+
+  __sync_synchronize();
+
+  rf_rx_packet_t *pkt = &RF_RxQueue[tail & RF_RX_QUEUE_MASK];
+
+  memcpy(RxBuffer, pkt->payload, sizeof(RxBuffer));
+  RF_last_rssi = pkt->rssi;
+  RF_last_protocol = pkt->protocol;
+
+  // make sure the correct timestamp is used for decoding
+  ThisAircraft.timestamp = pkt->time;
+
+  __sync_synchronize();
+  RF_RxQueue_Tail = tail + 1;
+
+  return true;
+}
+
+/* Decode a frame with the codec of the radio that has received it */
+bool RF_Decode(uint8_t protocol, void *buf, ufo_t *this_aircraft, ufo_t *fop)
 {
-  bool rval = false;
+  bool (*decode)(void *, ufo_t *, ufo_t *) = protocol_decode;
 
-  if (RF_ready && rf_chip) {
-    rval = rf_chip->receive();
+  for (uint8_t i = 1; i < RF_Radio_Count; i++) {
+    if (RF_Radios[i].protocol == protocol && protocol != settings->rf_protocol) {
+      decode = RF_Radios[i].decode;
+      break;
+    }
   }
-  if (rval) {
-    // make sure the correct timestamp is used for decoding
-    ThisAircraft.timestamp = slotTime;
+
+  return decode && (*decode)(buf, this_aircraft, fop);
+}
+
+bool RF_Receive(void)
+{
+  if (RF_ready) {
+    for (uint8_t i = 0; i < RF_Radio_Count; i++) {
+      RF_Radios[i].ops->receive();
+    }
   }
-  
-  return rval;
+
+  return RF_Dequeue();
 }
 
 void RF_Shutdown(void)
 {
-  if (rf_chip) {
-    rf_chip->shutdown();
+  for (uint8_t i = 0; i < RF_Radio_Count; i++) {
+    RF_Radios[i].ops->shutdown();
   }
 }
 
-uint8_t RF_Payload_Size(uint8_t protocol)
+static const rf_proto_desc_t *RF_Protocol_Desc(uint8_t protocol)
 {
   switch (protocol)
   {
-    case RF_PROTOCOL_LEGACY:    return legacy_proto_desc.payload_size;
-    case RF_PROTOCOL_OGNTP:     return ogntp_proto_desc.payload_size;
-    case RF_PROTOCOL_P3I:       return p3i_proto_desc.payload_size;
-    case RF_PROTOCOL_FANET:     return fanet_proto_desc.payload_size;
-    case RF_PROTOCOL_ADSB_UAT:  return uat978_proto_desc.payload_size;
-    default:                    return 0;
+    case RF_PROTOCOL_LEGACY:    return &legacy_proto_desc;
+    case RF_PROTOCOL_OGNTP:     return &ogntp_proto_desc;
+    case RF_PROTOCOL_P3I:       return &p3i_proto_desc;
+    case RF_PROTOCOL_FANET:     return &fanet_proto_desc;
+    case RF_PROTOCOL_ADSB_UAT:  return &uat978_proto_desc;
+    default:                    return NULL;
+  }
+}
+
+uint8_t RF_Payload_Size(uint8_t protocol)
+{
+  const rf_proto_desc_t *proto = RF_Protocol_Desc(protocol);
+
+  return proto ? proto->payload_size : 0;
+}
+
+/*
+ * Airtime accounting. Duty cycle limits of ETSI EN 300 220 sub-bands
+ * apply with the European and UK frequency plans; elsewhere (and off
+ * these sub-bands) there is no limit. Each sub-band has a credit that
+ * refills at its duty cycle rate up to RF_AIRTIME_WINDOW seconds worth.
+ */
+static const rf_subband_t RF_SubBands[] = {
+  { 863000000, 868000000,   10 },   /* h1.3:  0.1 % */
+  { 868000000, 868600000,  100 },   /* h1.4:  1 %   */
+  { 868700000, 869200000,   10 },   /* h1.5:  0.1 % */
+  { 869400000, 869650000, 1000 },   /* h1.6: 10 %   */
+  { 869700000, 870000000,  100 },   /* h1.7:  1 %   */
+};
+
+#define RF_SUBBANDS_NUM (sizeof(RF_SubBands) / sizeof(RF_SubBands[0]))
+
+static rf_airtime_t RF_Airtime_Credit[RF_SUBBANDS_NUM];
+
+/* usec on air of a frame with 'size' bytes of payload */
+uint32_t RF_Airtime(uint8_t protocol, size_t size)
+{
+  const rf_proto_desc_t *proto = RF_Protocol_Desc(protocol);
+  uint32_t bits, bitrate;
+
+  if (proto == NULL) {
+    return 0;
+  }
+
+  if (proto->modulation_type == RF_MODULATION_TYPE_LORA) {
+#if !defined(EXCLUDE_SX12XX)
+    return osticks2us(calcAirTime(LMIC.rps, size));
+#else
+    return 0;
+#endif /* EXCLUDE_SX12XX */
+  }
+
+  bits = (proto->payload_offset + size + proto->crc_size) * 8;
+  if (proto->whitening == RF_WHITENING_MANCHESTER) {
+    bits *= 2;
+  }
+  bits += (proto->preamble_size + proto->syncword_size) * 8;
+
+  switch (proto->bitrate)
+  {
+    case RF_BITRATE_38400:    bitrate = 38400;   break;
+    case RF_BITRATE_1042KBPS: bitrate = 1041667; break;
+    case RF_BITRATE_100KBPS:
+    default:                  bitrate = 100000;  break;
+  }
+
+  return (uint32_t) (((uint64_t) bits * 1000000 + bitrate - 1) / bitrate);
+}
+
+/* sub-band of the current channel, NULL when it is not duty cycle limited */
+static rf_airtime_t *RF_Airtime_SubBand(uint16_t *duty)
+{
+  if (RF_FreqPlan.Plan != RF_BAND_EU && RF_FreqPlan.Plan != RF_BAND_UK) {
+    return NULL;
+  }
+
+  uint32_t freq = RF_FreqPlan.getChanFrequency(RF_current_channel);
+
+  for (uint8_t i = 0; i < RF_SUBBANDS_NUM; i++) {
+    if (freq >= RF_SubBands[i].freq_min && freq < RF_SubBands[i].freq_max) {
+      rf_airtime_t *sb = &RF_Airtime_Credit[i];
+      int64_t limit = (int64_t) RF_SubBands[i].duty * RF_AIRTIME_WINDOW * 100;
+      uint64_t now = Time_micros64();
+
+      if (sb->stamp == 0) {
+        sb->credit = limit;
+      } else {
+        sb->credit += (int64_t) (now - sb->stamp) * RF_SubBands[i].duty / 10000;
+        if (sb->credit > limit) {
+          sb->credit = limit;
+        }
+      }
+      sb->stamp = now;
+
+      *duty = RF_SubBands[i].duty;
+      return sb;
+    }
+  }
+
+  return NULL;
+}
+
+/* may a frame of 'size' bytes go out now ? Relayed frames keep a reserve */
+bool RF_Airtime_Available(size_t size, uint8_t priority)
+{
+  uint16_t duty;
+  rf_airtime_t *sb = RF_Airtime_SubBand(&duty);
+
+  if (sb == NULL) {
+    return true;
+  }
+
+  int64_t reserve = priority == RF_TX_PRIORITY_RELAY ?
+                    (int64_t) duty * RF_AIRTIME_WINDOW * RF_AIRTIME_RELAY_RESERVE : 0;
+
+  return sb->credit - (int64_t) RF_Airtime(settings->rf_protocol, size) >= reserve;
+}
+
+static void RF_Airtime_Charge(size_t size)
+{
+  uint16_t duty;
+  rf_airtime_t *sb = RF_Airtime_SubBand(&duty);
+
+  if (sb != NULL) {
+    sb->credit -= RF_Airtime(settings->rf_protocol, size);
   }
 }
 
@@ -541,9 +1079,24 @@ uint8_t RF_Payload_Size(uint8_t protocol)
  *
  */
 
+enum
+{
+  NRF905_BE_RX,           /* listening, frames go into the Rx queue */
+  NRF905_BE_TX_PENDING,   /* frame loaded, waiting for the air to clear */
+  NRF905_BE_TX_ACTIVE     /* on air, waiting for DR */
+};
+
 static uint8_t nrf905_channel_prev = (uint8_t) -1;
+static uint8_t nrf905_channel_next = (uint8_t) -1;
 static bool nrf905_receive_active  = false;
 
+static uint8_t nrf905_state = NRF905_BE_RX;
+static unsigned long nrf905_tx_marker = 0;
+static byte nrf905_tx_buf[LEGACY_PAYLOAD_SIZE];
+
+/* tells the RF layer how an asynchronous transmission ended */
+static void (*nrf905_tx_done)(bool) = NULL;
+
 static bool nrf905_probe()
 {
   uint8_t addr[4];
@@ -593,7 +1146,17 @@ static bool nrf905_probe()
   return false;
 }
 
-static void nrf905_channel(uint8_t channel)
+static void nrf905_tx_complete(bool success)
+{
+  nrf905_state = NRF905_BE_RX;
+  nrf905_receive_active = false;
+
+  if (nrf905_tx_done) {
+    (*nrf905_tx_done)(success);
+  }
+}
+
+static void nrf905_set_channel(uint8_t channel)
 {
   if (channel != nrf905_channel_prev) {
 
@@ -611,6 +1174,66 @@ static void nrf905_channel(uint8_t channel)
   }
 }
 
+static void nrf905_channel(uint8_t channel)
+{
+  nrf905_channel_next = channel;
+
+  switch (nrf905_state)
+  {
+  case NRF905_BE_TX_ACTIVE:
+    /* retune once the frame is out */
+    return;
+  case NRF905_BE_TX_PENDING:
+    /* the frame belongs to the slot that has just ended */
+    if (channel != nrf905_channel_prev) {
+      nrf905_tx_complete(false);
+    }
+    break;
+  default:
+    break;
+  }
+
+  nrf905_set_channel(channel);
+}
+
+/*
+ * Advance the Tx state machine by one step without blocking.
+ * The library reads DR from the status register (NRF905_DR_SW) and
+ * holds nRF905_send() back while CD is high (NRF905_COLLISION_AVOID).
+ */
+static void nrf905_tx_poll()
+{
+  if (nrf905_state == NRF905_BE_TX_PENDING) {
+    if (nRF905_getState() == NRF905_RADIO_STATE_TX) {
+      /* DR of a previous frame is still to be collected */
+      nRF905_getData(NULL, 0);
+    }
+
+    if (nRF905_getState() != NRF905_RADIO_STATE_TX &&
+        nRF905_setData(nrf905_tx_buf, LEGACY_PAYLOAD_SIZE) &&
+        nRF905_send()) {
+      nrf905_state = NRF905_BE_TX_ACTIVE;
+      nrf905_tx_marker = millis();
+    } else if (millis() - nrf905_tx_marker > NRF905_TX_TIMEOUT) {
+      nrf905_tx_complete(false);
+    }
+  } else if (nrf905_state == NRF905_BE_TX_ACTIVE) {
+    /* DR goes high at the end of the frame */
+    nRF905_getData(NULL, 0);
+
+    if (nRF905_getState() != NRF905_RADIO_STATE_TX) {
+      nrf905_tx_complete(true);
+    } else if (millis() - nrf905_tx_marker > NRF905_TX_TIMEOUT) {
+      nRF905_enterStandBy();
+      nrf905_tx_complete(false);
+    }
+  }
+
+  if (nrf905_state == NRF905_BE_RX && nrf905_channel_next != nrf905_channel_prev) {
+    nrf905_set_channel(nrf905_channel_next);
+  }
+}
+
 static void nrf905_setup()
 {
   SoC->SPI_begin();
@@ -656,6 +1279,8 @@ static void nrf905_setup()
   protocol_encode = &legacy_encode;
   protocol_decode = &legacy_decode;
 
+  nrf905_tx_done = &RF_Tx_Done;
+
   /* Put IC into receive mode */
   nRF905_receive();
 }
@@ -664,39 +1289,60 @@ static bool nrf905_receive()
 {
   bool success = false;
 
+  nrf905_tx_poll();
+
+  if (nrf905_state != NRF905_BE_RX) {
+    return success;
+  }
+
   // Put into receive mode
   if (!nrf905_receive_active) {
     nRF905_receive();
     nrf905_receive_active = true;
   }
 
-  success = nRF905_getData(RxBuffer, LEGACY_PAYLOAD_SIZE);
+  byte buf[LEGACY_PAYLOAD_SIZE];
+
+  success = nRF905_getData(buf, LEGACY_PAYLOAD_SIZE);
   if (success) { // Got data
-    rx_packets_counter++;
+    RF_Enqueue(buf, LEGACY_PAYLOAD_SIZE, 0, RF_PROTOCOL_LEGACY);
   }
 
   return success;
 }
 
-static void nrf905_transmit()
+static bool nrf905_transmit()
 {
+    if (nrf905_state != NRF905_BE_RX) {
+      /* a frame on air is let finish, this one is refused */
+      if (nrf905_state == NRF905_BE_TX_ACTIVE) {
+        return false;
+      }
+      /* one still waiting for the air is replaced by this one */
+      nrf905_tx_complete(false);
+    }
+
     nrf905_receive_active = false;
 
     // Set address of device to send to
     byte addr[] = TXADDR;
     nRF905_setTXAddress(addr);
 
-    // Set payload data
-    nRF905_setData(&TxBuffer[0], LEGACY_PAYLOAD_SIZE );
+    /* TxBuffer may be reused before the air is clear */
+    memcpy(nrf905_tx_buf, &TxBuffer[0], LEGACY_PAYLOAD_SIZE);
 
-    // Send payload (send fails if other transmissions are going on, keep trying until success)
-    while (!nRF905_send()) {
-      yield();
-    } ;
+    nrf905_state = NRF905_BE_TX_PENDING;
+    nrf905_tx_marker = millis();
+
+    /* Send payload; if other transmissions are going on, RF_loop() retries */
+    nrf905_tx_poll();
+
+    return true;
 }
 
 static void nrf905_shutdown()
 {
+  nrf905_state = NRF905_BE_RX;
   nRF905_powerDown();
   SPI.end();
 }
@@ -919,6 +1565,8 @@ static void sx12xx_setup()
     break;
   }
 
+  RF_FrameDecode = RF_Frame_Decoder(LMIC.protocol, true);
+
   switch(settings->txpower)
   {
   case RF_TX_POWER_FULL:
@@ -1006,26 +1654,14 @@ static bool sx12xx_receive()
   };
 
   if (sx12xx_receive_complete == true) {
-
-    u1_t size = LMIC.dataLen - LMIC.protocol->payload_offset - LMIC.protocol->crc_size;
-
-    if (size >sizeof(RxBuffer)) {
-      size = sizeof(RxBuffer);
-    }
-
-    for (u1_t i=0; i < size; i++) {
-        RxBuffer[i] = LMIC.frame[i + LMIC.protocol->payload_offset];
-    }
-
-    RF_last_rssi = LMIC.rssi;
-    rx_packets_counter++;
+    /* the frame has been queued by sx12xx_rx_func() */
     success = true;
   }
 
   return success;
 }
 
-static void sx12xx_transmit()
+static bool sx12xx_transmit()
 {
     sx12xx_transmit_complete = false;
     sx12xx_receive_active = false;
@@ -1039,6 +1675,8 @@ static void sx12xx_transmit()
 
       yield();
     };
+
+    return true;
 }
 
 static void sx12xx_shutdown()
@@ -1063,10 +1701,6 @@ static void sx12xx_rx(osjobcb_t func) {
 
 static void sx12xx_rx_func (osjob_t* job) {
 
-  u1_t crc8, pkt_crc8;
-  u2_t crc16, pkt_crc16;
-  u1_t i;
-
   // SX1276 is in SLEEP after IRQ handler, Force it to enter RX mode
   sx12xx_receive_active = false;
 
@@ -1075,133 +1709,34 @@ static void sx12xx_rx_func (osjob_t* job) {
     return;
   }
 
-  switch (LMIC.protocol->crc_type)
-  {
-  case RF_CHECKSUM_TYPE_GALLAGER:
-  case RF_CHECKSUM_TYPE_NONE:
-     /* crc16 left not initialized */
-    break;
-  case RF_CHECKSUM_TYPE_CRC8_107:
-    crc8 = 0x71;     /* seed value */
-    break;
-  case RF_CHECKSUM_TYPE_CCITT_0000:
-    crc16 = 0x0000;  /* seed value */
-    break;
-  case RF_CHECKSUM_TYPE_CCITT_FFFF:
-  default:
-    crc16 = 0xffff;  /* seed value */
-    break;
-  }
-
   //Serial.print("Got ");
   //Serial.print(LMIC.dataLen);
   //Serial.println(" bytes");
 
-  switch (LMIC.protocol->type)
-  {
-  case RF_PROTOCOL_LEGACY:
-    /* take in account NRF905/FLARM "address" bytes */
-    crc16 = update_crc_ccitt(crc16, 0x31);
-    crc16 = update_crc_ccitt(crc16, 0xFA);
-    crc16 = update_crc_ccitt(crc16, 0xB6);
-    break;
-  case RF_PROTOCOL_P3I:
-  case RF_PROTOCOL_OGNTP:
-  default:
-    break;
-  }
-
-  for (i = LMIC.protocol->payload_offset;
-       i < (LMIC.dataLen - LMIC.protocol->crc_size);
-       i++)
-  {
-
-    switch (LMIC.protocol->crc_type)
-    {
-    case RF_CHECKSUM_TYPE_GALLAGER:
-    case RF_CHECKSUM_TYPE_NONE:
-      break;
-    case RF_CHECKSUM_TYPE_CRC8_107:
-      update_crc8(&crc8, (u1_t)(LMIC.frame[i]));
-      break;
-    case RF_CHECKSUM_TYPE_CCITT_FFFF:
-    case RF_CHECKSUM_TYPE_CCITT_0000:
-    default:
-      crc16 = update_crc_ccitt(crc16, (u1_t)(LMIC.frame[i]));
-      break;
-    }
+  u1_t offset = LMIC.protocol->payload_offset;
+  int  size   = LMIC.dataLen - LMIC.protocol->crc_size - offset;
 
-    switch (LMIC.protocol->whitening)
-    {
-    case RF_WHITENING_NICERF:
-      LMIC.frame[i] ^= pgm_read_byte(&whitening_pattern[i - LMIC.protocol->payload_offset]);
-      break;
-    case RF_WHITENING_MANCHESTER:
-    case RF_WHITENING_NONE:
-    default:
-      break;
-    }
+  /* dewhitening is done in place, Manchester code is removed by the IC */
+  sx12xx_receive_complete = size >= 0 &&
+                            RF_FrameDecode(LMIC.protocol, &LMIC.frame[offset], size,
+                                           &LMIC.frame[offset], NULL);
 
 #if DEBUG
+  for (int i = offset; i < LMIC.dataLen; i++) {
     Serial.printf("%02x", (u1_t)(LMIC.frame[i]));
-#endif
   }
-
-  switch (LMIC.protocol->crc_type)
-  {
-  case RF_CHECKSUM_TYPE_NONE:
-    sx12xx_receive_complete = true;
-    break;
-  case RF_CHECKSUM_TYPE_GALLAGER:
-    if (LDPC_Check((uint8_t  *) &LMIC.frame[0])) {
-#if DEBUG
-      Serial.printf(" %02x%02x%02x%02x%02x%02x is wrong FEC",
-        LMIC.frame[i], LMIC.frame[i+1], LMIC.frame[i+2],
-        LMIC.frame[i+3], LMIC.frame[i+4], LMIC.frame[i+5]);
-#endif
-      sx12xx_receive_complete = false;
-    } else {
-      sx12xx_receive_complete = true;
-    }
-    break;
-  case RF_CHECKSUM_TYPE_CRC8_107:
-    pkt_crc8 = LMIC.frame[i];
-#if DEBUG
-    if (crc8 == pkt_crc8 ) {
-      Serial.printf(" %02x is valid crc", pkt_crc8);
-    } else {
-      Serial.printf(" %02x is wrong crc", pkt_crc8);
-    }
-#endif
-    if (crc8 == pkt_crc8) {
-      sx12xx_receive_complete = true;
-    } else {
-      sx12xx_receive_complete = false;
-    }
-    break;
-  case RF_CHECKSUM_TYPE_CCITT_FFFF:
-  case RF_CHECKSUM_TYPE_CCITT_0000:
-  default:
-    pkt_crc16 = (LMIC.frame[i] << 8 | LMIC.frame[i+1]);
-#if DEBUG
-    if (crc16 == pkt_crc16 ) {
-      Serial.printf(" %04x is valid crc", pkt_crc16);
-    } else {
-      Serial.printf(" %04x is wrong crc", pkt_crc16);
-    }
+  Serial.printf(sx12xx_receive_complete ? " is valid" : " is wrong");
 #endif
-    if (crc16 == pkt_crc16) {
-      sx12xx_receive_complete = true;
-    } else {
-      sx12xx_receive_complete = false;
-    }
-    break;
-  }
 
 #if DEBUG
   Serial.println();
 #endif
 
+  if (sx12xx_receive_complete == true) {
+    RF_Enqueue(&LMIC.frame[LMIC.protocol->payload_offset],
+               LMIC.dataLen - LMIC.protocol->payload_offset - LMIC.protocol->crc_size,
+               LMIC.rssi, LMIC.protocol->type);
+  }
 }
 
 // Transmit the given string and call the given function afterwards
@@ -1210,24 +1745,6 @@ static void sx12xx_tx(unsigned char *buf, size_t size, osjobcb_t func) {
   u1_t crc8;
   u2_t crc16;
 
-  switch (LMIC.protocol->crc_type)
-  {
-  case RF_CHECKSUM_TYPE_GALLAGER:
-  case RF_CHECKSUM_TYPE_NONE:
-     /* crc16 left not initialized */
-    break;
-  case RF_CHECKSUM_TYPE_CRC8_107:
-    crc8 = 0x71;     /* seed value */
-    break;
-  case RF_CHECKSUM_TYPE_CCITT_0000:
-    crc16 = 0x0000;  /* seed value */
-    break;
-  case RF_CHECKSUM_TYPE_CCITT_FFFF:
-  default:
-    crc16 = 0xffff;  /* seed value */
-    break;
-  }
-  
   os_radio(RADIO_RST); // Stop RX first
   delay(1); // Wait a bit, without this os_radio below asserts, apparently because the state hasn't changed yet
 
@@ -1235,12 +1752,6 @@ static void sx12xx_tx(unsigned char *buf, size_t size, osjobcb_t func) {
 
   switch (LMIC.protocol->type)
   {
-  case RF_PROTOCOL_LEGACY:
-    /* take in account NRF905/FLARM "address" bytes */
-    crc16 = update_crc_ccitt(crc16, 0x31);
-    crc16 = update_crc_ccitt(crc16, 0xFA);
-    crc16 = update_crc_ccitt(crc16, 0xB6);
-    break;
   case RF_PROTOCOL_P3I:
     /* insert Net ID */
     LMIC.frame[LMIC.dataLen++] = (u1_t) ((LMIC.protocol->net_id >> 24) & 0x000000FF);
@@ -1252,15 +1763,18 @@ static void sx12xx_tx(unsigned char *buf, size_t size, osjobcb_t func) {
 
     /* insert byte with CRC-8 seed value when necessary */
     if (LMIC.protocol->crc_type == RF_CHECKSUM_TYPE_CRC8_107) {
-      LMIC.frame[LMIC.dataLen++] = crc8;
+      LMIC.frame[LMIC.dataLen++] = CRC8_107_SEED;
     }
 
     break;
+  case RF_PROTOCOL_LEGACY:
   case RF_PROTOCOL_OGNTP:
   default:
     break;
   }
 
+  u1_t start = LMIC.dataLen;
+
   for (u1_t i=0; i < size; i++) {
 
     switch (LMIC.protocol->whitening)
@@ -1275,24 +1789,12 @@ static void sx12xx_tx(unsigned char *buf, size_t size, osjobcb_t func) {
       break;
     }
 
-    switch (LMIC.protocol->crc_type)
-    {
-    case RF_CHECKSUM_TYPE_GALLAGER:
-    case RF_CHECKSUM_TYPE_NONE:
-      break;
-    case RF_CHECKSUM_TYPE_CRC8_107:
-      update_crc8(&crc8, (u1_t)(LMIC.frame[LMIC.dataLen]));
-      break;
-    case RF_CHECKSUM_TYPE_CCITT_FFFF:
-    case RF_CHECKSUM_TYPE_CCITT_0000:
-    default:
-      crc16 = update_crc_ccitt(crc16, (u1_t)(LMIC.frame[LMIC.dataLen]));
-      break;
-    }
-
     LMIC.dataLen++;
   }
 
+  crc16 = RF_Checksum(LMIC.protocol, &LMIC.frame[start], size);
+  crc8  = (u1_t) crc16;
+
   switch (LMIC.protocol->crc_type)
   {
   case RF_CHECKSUM_TYPE_GALLAGER:
@@ -1340,6 +1842,11 @@ static void sx12xx_tx_func (osjob_t* job) {
 static unsigned char uat_ringbuf[UAT_RINGBUF_SIZE];
 static unsigned int uatbuf_head = 0;
 Stratux_frame_t uatradio_frame;
+static int uat_erasures[LONG_FRAME_BYTES];
+
+/* room for a batch and the partial frame that may precede it */
+static uint8_t uatm_rxbuf[2 * UATM_BATCH_SIZE];
+static size_t  uatm_rxbuf_len = 0;
 
 const char UAT_ident[] PROGMEM = SOFTRF_IDENT;
 
@@ -1425,31 +1932,29 @@ static void uatm_setup()
 static bool uatm_receive()
 {
   bool success = false;
-  unsigned int uatbuf_tail;
   int rs_errors;
+  int avail;
 
-  while (UATSerial.available()) {
-    unsigned char c = UATSerial.read();
-
-    uat_ringbuf[uatbuf_head % UAT_RINGBUF_SIZE] = c;
+  while ((avail = UATSerial.available()) > 0) {
+    size_t pos = 0;
+    uatm_frame_t frame;
 
-    uatbuf_tail = uatbuf_head - sizeof(Stratux_frame_t);
-    uatbuf_head++;
-
-    if (uat_ringbuf[ uatbuf_tail      % UAT_RINGBUF_SIZE] == STRATUX_UATRADIO_MAGIC_1 &&
-        uat_ringbuf[(uatbuf_tail + 1) % UAT_RINGBUF_SIZE] == STRATUX_UATRADIO_MAGIC_2 &&
-        uat_ringbuf[(uatbuf_tail + 2) % UAT_RINGBUF_SIZE] == STRATUX_UATRADIO_MAGIC_3 &&
-        uat_ringbuf[(uatbuf_tail + 3) % UAT_RINGBUF_SIZE] == STRATUX_UATRADIO_MAGIC_4) {
+    while (avail-- > 0 && uatm_rxbuf_len < sizeof(uatm_rxbuf)) {
+      uatm_rxbuf[uatm_rxbuf_len++] = UATSerial.read();
+    }
 
-      unsigned char *pre_fec_buf = (unsigned char *) &uatradio_frame;
-      for (u1_t i=0; i < sizeof(Stratux_frame_t); i++) {
-          pre_fec_buf[i] = uat_ringbuf[(uatbuf_tail + i) % UAT_RINGBUF_SIZE];
-      }
+    while (uatm_decode(uatm_rxbuf, uatm_rxbuf_len, &pos, &frame)) {
+      int frame_type = frame.type;
 
-      int frame_type = correct_adsb_frame(uatradio_frame.data, &rs_errors);
+      if (frame_type == UATM_TYPE_RAW) {
+        /* Stratux UATradio, FEC is up to us */
+        memcpy(uatradio_frame.data, frame.data, frame.length);
 
-      if (frame_type == -1) {
-        continue;
+        int n_erasures = uat978_erasures(frame.length, uat_erasures);
+        frame_type = correct_adsb_frame_erasures(uatradio_frame.data,
+                                                 uat_erasures, n_erasures,
+                                                 &rs_errors);
+        frame.data = uatradio_frame.data;
       }
 
       u1_t size = 0;
@@ -1460,28 +1965,25 @@ static bool uatm_receive()
         size = LONG_FRAME_DATA_BYTES;
       }
 
-      if (size > sizeof(RxBuffer)) {
-        size = sizeof(RxBuffer);
-      }
-
       if (size > 0) {
-        memcpy(RxBuffer, uatradio_frame.data, size);
-
-        RF_last_rssi = uatradio_frame.rssi;
-        rx_packets_counter++;
+        /* keep on reading, more frames may be waiting in the serial buffer */
+        RF_Enqueue(frame.data, size, frame.rssi, RF_PROTOCOL_ADSB_UAT);
         success = true;
-
-        break;
       }
     }
+
+    /* keep the partial frame, if any, for the next round */
+    uatm_rxbuf_len -= pos;
+    memmove(uatm_rxbuf, uatm_rxbuf + pos, uatm_rxbuf_len);
   }
 
   return success;
 }
 
-static void uatm_transmit()
+static bool uatm_transmit()
 {
   /* Nothing to do */
+  return false;
 }
 
 static void uatm_shutdown()
@@ -1520,6 +2022,11 @@ static bool cc13xx_receive_complete  = false;
 static bool cc13xx_receive_active    = false;
 static bool cc13xx_transmit_complete = false;
 
+/* frame decoding scratch of the RX callback, RxBuffer is the consumer's */
+static byte cc13xx_RxBuffer[MAX_PKT_SIZE];
+static byte cc13xx_RxErr[MAX_PKT_SIZE];
+static int  cc13xx_erasures[LONG_FRAME_BYTES];
+
 void cc13xx_Receive_callback(EasyLink_RxPacket *rxPacket_ptr, EasyLink_Status status)
 {
   cc13xx_receive_active = false;
@@ -1530,64 +2037,14 @@ void cc13xx_Receive_callback(EasyLink_RxPacket *rxPacket_ptr, EasyLink_Status st
     size_t size = 0;
     uint8_t offset;
 
-    u1_t crc8, pkt_crc8;
-    u2_t crc16, pkt_crc16;
-
-#if !defined(EXCLUDE_OGLEP3)
-    switch (cc13xx_protocol->crc_type)
-    {
-    case RF_CHECKSUM_TYPE_GALLAGER:
-    case RF_CHECKSUM_TYPE_NONE:
-       /* crc16 left not initialized */
-      break;
-    case RF_CHECKSUM_TYPE_CRC8_107:
-      crc8 = 0x71;     /* seed value */
-      break;
-    case RF_CHECKSUM_TYPE_CCITT_0000:
-      crc16 = 0x0000;  /* seed value */
-      break;
-    case RF_CHECKSUM_TYPE_CCITT_FFFF:
-    default:
-      crc16 = 0xffff;  /* seed value */
-      break;
-    }
-
-    switch (cc13xx_protocol->type)
-    {
-    case RF_PROTOCOL_LEGACY:
-      /* take in account NRF905/FLARM "address" bytes */
-      crc16 = update_crc_ccitt(crc16, 0x31);
-      crc16 = update_crc_ccitt(crc16, 0xFA);
-      crc16 = update_crc_ccitt(crc16, 0xB6);
-      break;
-    case RF_PROTOCOL_P3I:
-    case RF_PROTOCOL_OGNTP:
-    default:
-      break;
-    }
-#endif /* EXCLUDE_OGLEP3 */
-
     switch (cc13xx_protocol->type)
     {
 #if !defined(EXCLUDE_OGLEP3)
     case RF_PROTOCOL_P3I:
-      uint8_t i;
       offset = cc13xx_protocol->payload_offset;
-      for (i = 0; i < cc13xx_protocol->payload_size; i++)
-      {
-        update_crc8(&crc8, (u1_t)(rxPacket_ptr->payload[i + offset]));
-        if (i < sizeof(RxBuffer)) {
-          RxBuffer[i] = rxPacket_ptr->payload[i + offset] ^
-                        pgm_read_byte(&whitening_pattern[i]);
-        }
-      }
-
-      pkt_crc8 = rxPacket_ptr->payload[i + offset];
-
-      if (crc8 == pkt_crc8) {
-
-        success = true;
-      }
+      success = RF_FrameDecode(cc13xx_protocol, &rxPacket_ptr->payload[offset],
+                               cc13xx_protocol->payload_size,
+                               cc13xx_RxBuffer, cc13xx_RxErr);
       break;
     case RF_PROTOCOL_OGNTP:
     case RF_PROTOCOL_LEGACY:
@@ -1603,52 +2060,9 @@ void cc13xx_Receive_callback(EasyLink_RxPacket *rxPacket_ptr, EasyLink_Status st
           rxPacket_ptr->payload[2] == cc13xx_protocol->syncword[6] &&
           (offset > 3 ? (rxPacket_ptr->payload[3] == cc13xx_protocol->syncword[7]) : true)) {
 
-        uint8_t i, val1, val2;
-        for (i = 0; i < size; i++) {
-          val1 = pgm_read_byte(&ManchesterDecode[rxPacket_ptr->payload[i + offset]]);
-          i++;
-          val2 = pgm_read_byte(&ManchesterDecode[rxPacket_ptr->payload[i + offset]]);
-          if ((i>>1) < sizeof(RxBuffer)) {
-            RxBuffer[i>>1] = ((val1 & 0x0F) << 4) | (val2 & 0x0F);
-
-            if (i < size - (cc13xx_protocol->crc_size + cc13xx_protocol->crc_size)) {
-              switch (cc13xx_protocol->crc_type)
-              {
-              case RF_CHECKSUM_TYPE_GALLAGER:
-              case RF_CHECKSUM_TYPE_NONE:
-                break;
-              case RF_CHECKSUM_TYPE_CCITT_FFFF:
-              case RF_CHECKSUM_TYPE_CCITT_0000:
-              default:
-                crc16 = update_crc_ccitt(crc16, (u1_t)(RxBuffer[i>>1]));
-                break;
-              }
-            }
-          }
-        }
-
-        switch (cc13xx_protocol->crc_type)
-        {
-        case RF_CHECKSUM_TYPE_GALLAGER:
-          if (LDPC_Check((uint8_t  *) &RxBuffer[0]) == 0) {
-
-            success = true;
-          }
-          break;
-        case RF_CHECKSUM_TYPE_CCITT_FFFF:
-        case RF_CHECKSUM_TYPE_CCITT_0000:
-          offset = cc13xx_protocol->payload_offset + cc13xx_protocol->payload_size;
-          if (offset + 1 < sizeof(RxBuffer)) {
-            pkt_crc16 = (RxBuffer[offset] << 8 | RxBuffer[offset+1]);
-            if (crc16 == pkt_crc16) {
-
-              success = true;
-            }
-          }
-          break;
-        default:
-          break;
-        }
+        success = RF_FrameDecode(cc13xx_protocol, &rxPacket_ptr->payload[offset],
+                                 cc13xx_protocol->payload_size,
+                                 cc13xx_RxBuffer, cc13xx_RxErr);
       }
       break;
 #endif /* EXCLUDE_OGLEP3 */
@@ -1656,7 +2070,11 @@ void cc13xx_Receive_callback(EasyLink_RxPacket *rxPacket_ptr, EasyLink_Status st
     default:
       int rs_errors;
       int frame_type;
-      frame_type = correct_adsb_frame(rxPacket_ptr->payload, &rs_errors);
+      int n_erasures;
+      n_erasures = uat978_erasures(rxPacket_ptr->len, cc13xx_erasures);
+      frame_type = correct_adsb_frame_erasures(rxPacket_ptr->payload,
+                                               cc13xx_erasures, n_erasures,
+                                               &rs_errors);
 
       if (frame_type != -1) {
 
@@ -1666,12 +2084,12 @@ void cc13xx_Receive_callback(EasyLink_RxPacket *rxPacket_ptr, EasyLink_Status st
           size = LONG_FRAME_DATA_BYTES;
         }
 
-        if (size > sizeof(RxBuffer)) {
-          size = sizeof(RxBuffer);
+        if (size > sizeof(cc13xx_RxBuffer)) {
+          size = sizeof(cc13xx_RxBuffer);
         }
 
         if (size > 0) {
-          memcpy(RxBuffer, rxPacket_ptr->payload, size);
+          memcpy(cc13xx_RxBuffer, rxPacket_ptr->payload, size);
 
           success = true;
         }
@@ -1680,8 +2098,8 @@ void cc13xx_Receive_callback(EasyLink_RxPacket *rxPacket_ptr, EasyLink_Status st
     }
 
     if (success) {
-      RF_last_rssi = rxPacket_ptr->rssi;
-      rx_packets_counter++;
+      RF_Enqueue(cc13xx_RxBuffer, sizeof(cc13xx_RxBuffer),
+                 rxPacket_ptr->rssi, cc13xx_protocol->type);
 
       cc13xx_receive_complete  = true;
     }
@@ -1790,6 +2208,8 @@ static void cc13xx_setup()
     break;
   }
 
+  RF_FrameDecode = RF_Frame_Decoder(cc13xx_protocol, false);
+
   /* -10 dBm is a minumum for CC1310 ; CC1352 can operate down to -20 dBm */
   int8_t TxPower = -10;
 
@@ -1820,7 +2240,7 @@ static bool cc13xx_receive()
   return cc13xx_Receive_Async();
 }
 
-static void cc13xx_transmit()
+static bool cc13xx_transmit()
 {
 #if !defined(EXCLUDE_OGLEP3)
   EasyLink_Status status;
@@ -1830,11 +2250,11 @@ static void cc13xx_transmit()
   u1_t i;
 
   if (RF_tx_size <= 0) {
-    return;
+    return false;
   }
 
   if (cc13xx_protocol->type == RF_PROTOCOL_ADSB_UAT) {
-    return; /* no transmit on UAT */
+    return false; /* no transmit on UAT */
   }
 
   EasyLink_abort();
@@ -1844,24 +2264,6 @@ static void cc13xx_transmit()
 
   size_t PayloadLen = 0;
 
-  switch (cc13xx_protocol->crc_type)
-  {
-  case RF_CHECKSUM_TYPE_GALLAGER:
-  case RF_CHECKSUM_TYPE_NONE:
-     /* crc16 left not initialized */
-    break;
-  case RF_CHECKSUM_TYPE_CRC8_107:
-    crc8 = 0x71;     /* seed value */
-    break;
-  case RF_CHECKSUM_TYPE_CCITT_0000:
-    crc16 = 0x0000;  /* seed value */
-    break;
-  case RF_CHECKSUM_TYPE_CCITT_FFFF:
-  default:
-    crc16 = 0xffff;  /* seed value */
-    break;
-  }
-
   for (i = MAX_SYNCWORD_SIZE; i < cc13xx_protocol->syncword_size; i++)
   {
     txPacket.payload[PayloadLen++] = cc13xx_protocol->syncword[i];
@@ -1869,12 +2271,6 @@ static void cc13xx_transmit()
 
   switch (cc13xx_protocol->type)
   {
-  case RF_PROTOCOL_LEGACY:
-    /* take in account NRF905/FLARM "address" bytes */
-    crc16 = update_crc_ccitt(crc16, 0x31);
-    crc16 = update_crc_ccitt(crc16, 0xFA);
-    crc16 = update_crc_ccitt(crc16, 0xB6);
-    break;
   case RF_PROTOCOL_P3I:
     /* insert Net ID */
     txPacket.payload[PayloadLen++] = (u1_t) ((cc13xx_protocol->net_id >> 24) & 0x000000FF);
@@ -1886,15 +2282,18 @@ static void cc13xx_transmit()
 
     /* insert byte with CRC-8 seed value when necessary */
     if (cc13xx_protocol->crc_type == RF_CHECKSUM_TYPE_CRC8_107) {
-      txPacket.payload[PayloadLen++] = crc8;
+      txPacket.payload[PayloadLen++] = CRC8_107_SEED;
     }
 
     break;
+  case RF_PROTOCOL_LEGACY:
   case RF_PROTOCOL_OGNTP:
   default:
     break;
   }
 
+  size_t start = PayloadLen;
+
   for (i=0; i < RF_tx_size; i++) {
 
     switch (cc13xx_protocol->whitening)
@@ -1913,28 +2312,17 @@ static void cc13xx_transmit()
       break;
     }
 
-    switch (cc13xx_protocol->crc_type)
-    {
-    case RF_CHECKSUM_TYPE_GALLAGER:
-    case RF_CHECKSUM_TYPE_NONE:
-      break;
-    case RF_CHECKSUM_TYPE_CRC8_107:
-      update_crc8(&crc8, (u1_t)(txPacket.payload[PayloadLen]));
-      break;
-    case RF_CHECKSUM_TYPE_CCITT_FFFF:
-    case RF_CHECKSUM_TYPE_CCITT_0000:
-    default:
-      if (cc13xx_protocol->whitening == RF_WHITENING_MANCHESTER) {
-        crc16 = update_crc_ccitt(crc16, (u1_t)(TxBuffer[i]));
-      } else {
-        crc16 = update_crc_ccitt(crc16, (u1_t)(txPacket.payload[PayloadLen]));
-      }
-      break;
-    }
-
     PayloadLen++;
   }
 
+  /* Manchester coded frames carry checksum of the plain data */
+  if (cc13xx_protocol->whitening == RF_WHITENING_MANCHESTER) {
+    crc16 = RF_Checksum(cc13xx_protocol, TxBuffer, RF_tx_size);
+  } else {
+    crc16 = RF_Checksum(cc13xx_protocol, &txPacket.payload[start], RF_tx_size);
+  }
+  crc8 = (u1_t) crc16;
+
   switch (cc13xx_protocol->crc_type)
   {
   case RF_CHECKSUM_TYPE_GALLAGER:
@@ -1975,6 +2363,9 @@ static void cc13xx_transmit()
   myLink.transmit(&txPacket);
 #endif
 
+  return true;
+#else
+  return false;
 #endif /* EXCLUDE_OGLEP3 */
 }
 
@@ -1996,9 +2387,18 @@ static RFM_TRX  TRX;
 static uint8_t ognrf_channel_prev  = (uint8_t) -1;
 static bool ognrf_receive_active   = false;
 
+#if defined(USE_BLOCK_SPI)
+void RFM_TransferBlock(uint8_t *Data, uint8_t Len)
+{
+  hal_pin_nss(0);
+  hal_spi_block(Data, Len);
+  hal_pin_nss(1);
+}
+#else
 void RFM_Select  (void)                 { hal_pin_nss(0); }
 void RFM_Deselect(void)                 { hal_pin_nss(1); }
 uint8_t RFM_TransferByte(uint8_t Byte)  { return hal_spi(Byte); }
+#endif /* USE_BLOCK_SPI */
 
 bool RFM_IRQ_isOn(void)   { return lmic_pins.dio[0] == LMIC_UNUSED_PIN ? \
                                   false : digitalRead(lmic_pins.dio[0]); }
@@ -2019,9 +2419,13 @@ static bool ognrf_probe()
 {
   bool success = false;
 
+#if defined(USE_BLOCK_SPI)
+  TRX.TransferBlock = RFM_TransferBlock;
+#else
   TRX.Select       = RFM_Select;
   TRX.Deselect     = RFM_Deselect;
   TRX.TransferByte = RFM_TransferByte;
+#endif /* USE_BLOCK_SPI */
   TRX.RESET        = RFM_RESET;
 
   SoC->SPI_begin();
@@ -2085,9 +2489,13 @@ static void ognrf_setup()
   protocol_encode = &ogntp_encode;
   protocol_decode = &ogntp_decode;
 
+#if defined(USE_BLOCK_SPI)
+  TRX.TransferBlock = RFM_TransferBlock;
+#else
   TRX.Select       = RFM_Select;
   TRX.Deselect     = RFM_Deselect;
   TRX.TransferByte = RFM_TransferByte;
+#endif /* USE_BLOCK_SPI */
   TRX.DIO0_isOn    = RFM_IRQ_isOn;
   TRX.RESET        = RFM_RESET;
 
@@ -2145,6 +2553,7 @@ static bool ognrf_receive()
 
   uint8_t RxRSSI = 0;
   uint8_t Err [OGNTP_PAYLOAD_SIZE + OGNTP_CRC_SIZE];
+  uint8_t Buf [OGNTP_PAYLOAD_SIZE + OGNTP_CRC_SIZE];
 
   // Put into receive mode
   if (!ognrf_receive_active) {
@@ -2161,15 +2570,14 @@ static bool ognrf_receive()
   if(TRX.DIO0_isOn()) {
     RxRSSI = TRX.ReadRSSI();
 
-    TRX.ReadPacket(RxBuffer, Err);
-    if (LDPC_Check((uint8_t  *) RxBuffer) == 0) {
+    TRX.ReadPacket(Buf, Err);
+    if (LDPC_Check((uint8_t  *) Buf) == 0 || RF_LDPC_Decode(Buf, Err) >= 0) {
       success = true;
     }
   }
 
   if (success) {
-    RF_last_rssi = RxRSSI;
-    rx_packets_counter++;
+    RF_Enqueue(Buf, sizeof(Buf), RxRSSI, RF_PROTOCOL_OGNTP);
   }
 
 #endif /* WITH_SI4X32 */
@@ -2177,7 +2585,7 @@ static bool ognrf_receive()
   return success;
 }
 
-static void ognrf_transmit()
+static bool ognrf_transmit()
 {
   ognrf_receive_active = false;
 
@@ -2211,6 +2619,8 @@ static void ognrf_transmit()
   TRX.WriteMode(RF_OPMODE_STANDBY);
 
 #endif /* WITH_SI4X32 */
+
+  return true;
 }
 
 static void ognrf_shutdown()
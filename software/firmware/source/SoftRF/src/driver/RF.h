@@ -30,7 +30,7 @@
 #include <lmic.h>
 #endif
 #include <hal/hal.h>
-#include <lib_crc.h>
+#include <crc_fast.h>
 #include <protocol.h>
 #include <freqplan.h>
 
@@ -51,6 +51,38 @@
                              P3I_PAYLOAD_SIZE, FANET_PAYLOAD_SIZE, \
                              UAT978_PAYLOAD_SIZE)
 
+/* Received frames waiting for ParseData(), has to be a power of two */
+#if !defined(RF_RX_QUEUE_SIZE)
+#define RF_RX_QUEUE_SIZE  8
+#endif
+#define RF_RX_QUEUE_MASK  (RF_RX_QUEUE_SIZE - 1)
+
+/* Max. number of frames ParseData() takes in one call */
+#define RF_RX_BATCH       RF_RX_QUEUE_SIZE
+
+/* duty cycle is averaged over this many seconds */
+#if !defined(RF_AIRTIME_WINDOW)
+#define RF_AIRTIME_WINDOW     3600
+#endif
+/* percentage of the sub-band budget that relayed frames leave untouched */
+#define RF_AIRTIME_RELAY_RESERVE  25
+
+/* ms an nRF905 frame may wait for a clear channel, or for DR */
+#define NRF905_TX_TIMEOUT     100
+
+/* radios RF_setup() may bring up, each one has to be of another RFIC type */
+#if !defined(RF_MAX_RADIOS)
+#define RF_MAX_RADIOS         1
+#endif
+
+/* no protocol assigned, secondary radio is not used */
+#define RF_PROTOCOL_NONE      0xFF
+
+/* seconds of hopping schedule precomputed by RF_SetChannel() */
+#if !defined(RF_HOP_CACHE_SECONDS)
+#define RF_HOP_CACHE_SECONDS  4
+#endif
+
 #define RXADDR {0x31, 0xfa , 0xb6} // Address of this device (4 bytes)
 #define TXADDR {0x31, 0xfa , 0xb6} // Address of device to send to (4 bytes)
 
@@ -72,6 +104,33 @@ enum
   RF_TX_POWER_OFF
 };
 
+typedef struct rf_rx_packet_struct {
+  time_t        time;       /* slot time, for decoding */
+  unsigned long ms;         /* millis() at reception */
+  int8_t        rssi;
+  uint8_t       channel;
+  uint8_t       protocol;
+  uint8_t       size;
+  byte          payload[MAX_PKT_SIZE];
+} rf_rx_packet_t;
+
+enum
+{
+  RF_TX_PRIORITY_OWN,
+  RF_TX_PRIORITY_RELAY
+};
+
+typedef struct rf_subband_struct {
+  uint32_t      freq_min;   /* Hz */
+  uint32_t      freq_max;
+  uint16_t      duty;       /* in 1/10000 */
+} rf_subband_t;
+
+typedef struct rf_airtime_struct {
+  int64_t       credit;     /* usec of airtime left */
+  uint64_t      stamp;      /* Time_micros64() of the last refill */
+} rf_airtime_t;
+
 typedef struct rfchip_ops_struct {
   byte type;
   const char name[8];
@@ -79,10 +138,18 @@ typedef struct rfchip_ops_struct {
   void (*setup)();
   void (*channel)(uint8_t);
   bool (*receive)();
-  void (*transmit)();
+  bool (*transmit)();
   void (*shutdown)();
 } rfchip_ops_t;
 
+typedef struct rf_radio_struct {
+  const rfchip_ops_t *ops;
+  uint8_t       protocol;   /* as the driver has set it up */
+  uint8_t       channel;
+  size_t        (*encode)(void *, ufo_t *);
+  bool          (*decode)(void *, ufo_t *, ufo_t *);
+} rf_radio_t;
+
 String Bin2Hex(byte *, size_t);
 uint8_t parity(uint32_t);
 
@@ -92,17 +159,28 @@ void    RF_loop(void);
 size_t  RF_Encode(ufo_t *);
 bool    RF_Transmit(size_t, bool);
 bool    RF_Receive(void);
+bool    RF_Dequeue(void);
+bool    RF_Decode(uint8_t, void *, ufo_t *, ufo_t *);
+int     RF_LDPC_Decode(uint8_t *, const uint8_t *);
 void    RF_Shutdown(void);
 uint8_t RF_Payload_Size(uint8_t);
+uint32_t RF_Airtime(uint8_t, size_t);
+bool    RF_Airtime_Available(size_t, uint8_t);
 
 extern byte TxBuffer[MAX_PKT_SIZE], RxBuffer[MAX_PKT_SIZE];
-extern unsigned long TxTimeMarker;
+extern uint64_t TxTimeMarker;
 
 extern const rfchip_ops_t *rf_chip;
+extern rf_radio_t RF_Radios[RF_MAX_RADIOS];
+extern uint8_t RF_Radio_Count;
 extern bool RF_SX12XX_RST_is_connected;
 extern size_t (*protocol_encode)(void *, ufo_t *);
 extern bool (*protocol_decode)(void *, ufo_t *, ufo_t *);
 
 extern int8_t RF_last_rssi;
+extern uint8_t RF_last_protocol;
+extern uint32_t tx_packets_lost;
+extern uint32_t rx_packets_counter, rx_packets_lost;
+extern uint32_t rx_packets_corrected, rx_bits_corrected;
 
 #endif /* RFHELPER_H */
@@ -599,6 +599,7 @@ static float CC13XX_Battery_param(uint8_t param)
 }
 
 void CC13XX_GNSS_PPS_Interrupt_handler() {
+  PPS_TimeMarker_us = micros();
   PPS_TimeMarker = millis();
 }
 
@@ -26,7 +26,9 @@ extern char *itoa(int, char *, int);
 #endif /* ENERGIA_ARCH_CC13X2 */
 
 /* Maximum of tracked flying objects is now SoC-specific constant */
+#if !defined(MAX_TRACKING_OBJECTS)
 #define MAX_TRACKING_OBJECTS    8
+#endif /* MAX_TRACKING_OBJECTS */
 
 #define DEFAULT_SOFTRF_MODEL    SOFTRF_MODEL_UAT
 
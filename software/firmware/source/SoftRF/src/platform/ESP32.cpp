@@ -1194,6 +1194,7 @@ static float ESP32_Battery_param(uint8_t param)
 static void IRAM_ATTR ESP32_GNSS_PPS_Interrupt_handler()
 {
   portENTER_CRITICAL_ISR(&GNSS_PPS_mutex);
+  PPS_TimeMarker_us = micros(); /* so has micros() */
   PPS_TimeMarker = millis();    /* millis() has IRAM_ATTR */
   portEXIT_CRITICAL_ISR(&GNSS_PPS_mutex);
 }
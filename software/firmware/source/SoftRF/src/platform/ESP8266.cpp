@@ -365,6 +365,7 @@ static float ESP8266_Battery_param(uint8_t param)
 
 void ESP8266_GNSS_PPS_Interrupt_handler()
 {
+  PPS_TimeMarker_us = micros();
   PPS_TimeMarker = millis();
 }
 
@@ -36,7 +36,9 @@
 #include <Adafruit_NeoPixel.h>
 
 /* Maximum of tracked flying objects is now SoC-specific constant */
+#if !defined(MAX_TRACKING_OBJECTS)
 #define MAX_TRACKING_OBJECTS    8
+#endif /* MAX_TRACKING_OBJECTS */
 
 #define DEFAULT_SOFTRF_MODEL    SOFTRF_MODEL_STANDALONE
 
@@ -481,6 +481,7 @@ static float PSoC4_Battery_param(uint8_t param)
 }
 
 void PSoC4_GNSS_PPS_Interrupt_handler() {
+  PPS_TimeMarker_us = micros();
   PPS_TimeMarker = millis();
 }
 
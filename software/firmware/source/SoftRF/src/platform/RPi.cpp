@@ -59,6 +59,7 @@
 #include "../protocol/data/GDL90.h"
 #include "../protocol/data/D1090.h"
 #include "../protocol/data/JSON.h"
+#include "../protocol/data/FISB.h"
 #include "../driver/WiFi.h"
 #include "../driver/EPD.h"
 #include "../driver/Battery.h"
@@ -255,6 +256,7 @@ static void RPi_setup()
   eeprom_block.field.version                = SOFTRF_EEPROM_VERSION;
   eeprom_block.field.settings.mode          = SOFTRF_MODE_NORMAL;
   eeprom_block.field.settings.rf_protocol   = RF_PROTOCOL_OGNTP;
+  eeprom_block.field.settings.rf_protocol2  = RF_PROTOCOL_NONE;
   eeprom_block.field.settings.band          = RF_BAND_EU;
   eeprom_block.field.settings.aircraft_type = AIRCRAFT_TYPE_GLIDER;
   eeprom_block.field.settings.txpower       = RF_TX_POWER_FULL;
@@ -450,6 +452,7 @@ static float RPi_Battery_param(uint8_t param)
 }
 
 void RPi_GNSS_PPS_Interrupt_handler() {
+  PPS_TimeMarker_us = micros();
   PPS_TimeMarker = millis();
 }
 
@@ -615,6 +618,10 @@ static void RPi_PickGNSSFix()
       // NMEA input
       parseNMEA(str, len);
 
+    } else if (str[0] == '+') {
+      // UAT uplink, 'dump978' text format
+      FISB_Uplink_Hex(str + 1, len - 1, now());
+
     } else if (str[0] == '{') {
       // JSON input
 
@@ -661,7 +668,10 @@ static void RPi_ReadTraffic()
     const char *str = traffic_input.c_str();
     int len = traffic_input.length();
 
-    if (str[0] == '{') {
+    if (str[0] == '+') {
+      // UAT uplink, 'dump978' text format
+      FISB_Uplink_Hex(str + 1, len - 1, now());
+    } else if (str[0] == '{') {
       // JSON input
 
 //    cout << "Traffic message:" << traffic_input << endl;
@@ -739,13 +749,14 @@ void normal_loop()
       Traffic_loop();
     }
 
+    FISB_loop();
+
     if (isTimeToExport()) {
       NMEA_Export();
 
       if (isValidFix()) {
         GDL90_Export();
         D1090_Export();
-        JSON_Export();
       }
       ExportTimeMarker = millis();
     }
@@ -756,6 +767,8 @@ void normal_loop()
     SoC->Display_loop();
 
     ClearExpired();
+
+    Traffic_Snapshot_Publish();
 }
 
 void relay_loop()
@@ -770,14 +783,32 @@ void relay_loop()
 
     RF_loop();
 
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
+    int j = 0;
+
+    for (int i = 0; i < Traffic_Count(); i++) {
+      traffic_by_dist[j].fop = Traffic_Entry(i);
+      traffic_by_dist[j].distance = traffic_by_dist[j].fop->distance;
+      j++;
+    }
+
+    /* most threatening traffic gets the remaining airtime first */
+    qsort(traffic_by_dist, j, sizeof(traffic_by_dist_t), traffic_cmp_by_alarm);
+
+    for (int i = 0; i < j; i++) {
+      ufo_t *fop = traffic_by_dist[i].fop;
+      ufo_cold_t *cold = Traffic_Cold(fop);
+
       size_t size = RF_Payload_Size(settings->rf_protocol);
-      size = size > sizeof(Container[i].raw) ? sizeof(Container[i].raw) : size;
+      size = size > sizeof(cold->raw) ? sizeof(cold->raw) : size;
 
-      if (memcmp (Container[i].raw, EmptyFO.raw, size) != 0) {
+      if (!RF_Airtime_Available(size, RF_TX_PRIORITY_RELAY)) {
+        break;
+      }
+
+      if (memcmp (cold->raw, EmptyFO_Cold.raw, size) != 0) {
         // Raw data
         size_t tx_size = sizeof(TxBuffer) > size ? size : sizeof(TxBuffer);
-        memcpy(TxBuffer, Container[i].raw, tx_size);
+        memcpy(TxBuffer, cold->raw, tx_size);
 
         if (tx_size > 0) {
           /* Follow duty cycle rule */
@@ -786,17 +817,17 @@ void relay_loop()
             String str = Bin2Hex(TxBuffer, tx_size);
             printf("%s\n", str.c_str());
 #endif
-            Container[i] = EmptyFO;
+            Traffic_Remove(fop);
           }
         }
       } else if (isValidFix() &&
-                 Container[i].addr &&
-                 Container[i].latitude  != 0.0 &&
-                 Container[i].longitude != 0.0 &&
-                 Container[i].altitude  != 0.0 &&
-                 Container[i].distance < (ALARM_ZONE_NONE * 2) ) {
+                 fop->addr &&
+                 fop->latitude  != 0.0 &&
+                 fop->longitude != 0.0 &&
+                 fop->altitude  != 0.0 &&
+                 fop->distance < (ALARM_ZONE_NONE * 2) ) {
 
-        fo = Container[i];
+        fo = *fop;
         fo.timestamp = now(); /* GNSS date&time */
 
         /* Follow duty cycle rule */
@@ -811,10 +842,12 @@ void relay_loop()
               (int) fo.vs,
               fo.aircraft_type);
 #endif
-          Container[i] = EmptyFO;
+          Traffic_Remove(fop);
         }
       }
     }
+
+    Traffic_Snapshot_Publish();
 }
 
 unsigned int pos_ndx = 0;
@@ -931,6 +964,19 @@ void * traffic_tcpserv_loop(void * m)
   Traffic_TCP_Server.receive();
 }
 
+/* JSON export runs off the traffic snapshots, away from the main loop */
+void * traffic_export_loop(void *)
+{
+  pthread_detach(pthread_self());
+
+  for (;;) {
+    if (settings->mode == SOFTRF_MODE_NORMAL) {
+      JSON_Export();
+    }
+    delay(1000);
+  }
+}
+
 int main()
 {
   // Init GPIO bcm
@@ -976,6 +1022,7 @@ int main()
 
   Traffic_setup();
   NMEA_setup();
+  FISB_setup();
 
   Traffic_TCP_Server.setup(JSON_SRV_TCP_PORT);
 
@@ -985,6 +1032,12 @@ int main()
     exit(EXIT_FAILURE);
   }
 
+  pthread_t traffic_export_thread;
+  if ( pthread_create(&traffic_export_thread, NULL, traffic_export_loop, (void *)0) != 0) {
+    fprintf( stderr, "pthread_create(traffic_export_thread) Failed\n\n" );
+    exit(EXIT_FAILURE);
+  }
+
   SoC->post_init();
 
   SoC->WDT_setup();
@@ -1035,6 +1088,8 @@ void shutdown(int reason)
 {
   SoC->WDT_fini();
 
+  FISB_fini();
+
   if (hw_info.display != DISPLAY_NONE) {
     SoC->Display_fini(reason);
   }
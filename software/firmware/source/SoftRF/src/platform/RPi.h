@@ -22,7 +22,9 @@
 #define PLATFORM_RPI_H
 
 /* Maximum of tracked flying objects is now SoC-specific constant */
-#define MAX_TRACKING_OBJECTS  8
+#if !defined(MAX_TRACKING_OBJECTS)
+#define MAX_TRACKING_OBJECTS  256
+#endif /* MAX_TRACKING_OBJECTS */
 
 #define DEFAULT_SOFTRF_MODEL    SOFTRF_MODEL_RASPBERRY
 
@@ -106,10 +108,14 @@ extern TTYSerial Serial2;
 #define EXCLUDE_CC13XX
 #define EXCLUDE_LK8EX1
 
+/* e.g. SX1276 HAT on Legacy or OGNTP along with UATM on UAT */
+#define RF_MAX_RADIOS         2
+
 #define USE_NMEALIB
 //#define USE_EPAPER
 
 #define TAKE_CARE_OF_MILLIS_ROLLOVER
+#define USE_TRAFFIC_SNAPSHOT
 
 //#define EXCLUDE_GNSS_UBLOX
 #define EXCLUDE_GNSS_SONY
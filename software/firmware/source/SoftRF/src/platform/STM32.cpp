@@ -603,6 +603,7 @@ static float STM32_Battery_param(uint8_t param)
 }
 
 void STM32_GNSS_PPS_Interrupt_handler() {
+  PPS_TimeMarker_us = micros();
   PPS_TimeMarker = millis();
 }
 
@@ -1120,6 +1120,7 @@ static float nRF52_Battery_param(uint8_t param)
 }
 
 void nRF52_GNSS_PPS_Interrupt_handler() {
+  PPS_TimeMarker_us = micros();
   PPS_TimeMarker = millis();
 }
 
@@ -77,63 +77,65 @@ void D1090_Export()
   time_t this_moment = now();
 
   if (settings->d1090 != D1090_OFF) {
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-      if (Container[i].addr && (this_moment - Container[i].timestamp) <= EXPORT_EXPIRATION_TIME) {
+    for (int i=0; i < Traffic_Count(); i++) {
+      ufo_t *fop = Traffic_Entry(i);
 
-        distance = Container[i].distance;
+      if (fop->addr && (this_moment - fop->timestamp) <= EXPORT_EXPIRATION_TIME) {
+
+        distance = fop->distance;
 
         if (distance < ALARM_ZONE_NONE) {
 
           float altitude;
           /* If the aircraft's data has standard pressure altitude - make use it */
-          if (Container[i].pressure_altitude != 0.0) {
-            altitude = Container[i].pressure_altitude;
+          if (fop->pressure_altitude != 0.0) {
+            altitude = fop->pressure_altitude;
           } else if (ThisAircraft.pressure_altitude != 0.0) {
             /* If this SoftRF unit is equiped with baro sensor - try to make an adjustment */
             float altDiff = ThisAircraft.pressure_altitude - ThisAircraft.altitude;
-            altitude = Container[i].altitude + altDiff;
+            altitude = fop->altitude + altDiff;
           } else {
             /* If no other choice - report GNSS altitude as pressure altitude */
-            altitude = Container[i].altitude;
+            altitude = fop->altitude;
           }
           altitude *= _GPS_FEET_PER_METER;
 
-          df17 = make_air_position_frame(11, Container[i].addr,
-            Container[i].latitude, Container[i].longitude,
+          df17 = make_air_position_frame(11, fop->addr,
+            fop->latitude, fop->longitude,
             altitude, CPR_EVEN, DF17);
 
           str = "*";
           DF17_FRAME_TO_HEX_STR(str);
           str += ";\r\n*";
 
-          df17 = make_air_position_frame(11, Container[i].addr,
-            Container[i].latitude, Container[i].longitude,
+          df17 = make_air_position_frame(11, fop->addr,
+            fop->latitude, fop->longitude,
             altitude, CPR_ODD, DF17);
 
           DF17_FRAME_TO_HEX_STR(str);
           str += ";\r\n*";
 
-          String callsign = String(GDL90_CallSign_Prefix[Container[i].protocol]);
+          String callsign = String(GDL90_CallSign_Prefix[fop->protocol]);
         
-          ADDR_TO_HEX_STR(callsign, (Container[i].addr >> 16) & 0xFF);
-          ADDR_TO_HEX_STR(callsign, (Container[i].addr >>  8) & 0xFF);
-          ADDR_TO_HEX_STR(callsign, (Container[i].addr      ) & 0xFF);
+          ADDR_TO_HEX_STR(callsign, (fop->addr >> 16) & 0xFF);
+          ADDR_TO_HEX_STR(callsign, (fop->addr >>  8) & 0xFF);
+          ADDR_TO_HEX_STR(callsign, (fop->addr      ) & 0xFF);
 
           callsign.toUpperCase();
 
-          df17 = make_aircraft_identification_frame(Container[i].addr,
+          df17 = make_aircraft_identification_frame(fop->addr,
             (unsigned char*) callsign.c_str(),
             Category_Set_D,
-            AT_TO_GDL90(Container[i].aircraft_type),
+            AT_TO_GDL90(fop->aircraft_type),
             DF17);
 
           DF17_FRAME_TO_HEX_STR(str);
           str += ";\r\n*";
 
-          df17 = make_velocity_frame(Container[i].addr,
-            Container[i].speed * cos(Container[i].course * PI / 180),
-            Container[i].speed * sin(Container[i].course * PI / 180),
-            Container[i].vs,
+          df17 = make_velocity_frame(fop->addr,
+            fop->speed * cos(fop->course * PI / 180),
+            fop->speed * sin(fop->course * PI / 180),
+            fop->vs,
             DF17);
 
           DF17_FRAME_TO_HEX_STR(str);
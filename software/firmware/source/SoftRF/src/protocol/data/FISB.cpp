@@ -0,0 +1,678 @@
+/*
+ * FISBHelper.cpp
+ * Copyright (C) 2021 Linar Yusupov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined(RASPBERRY_PI)
+
+#include <pthread.h>
+#include <unistd.h>
+#include <TimeLib.h>
+
+#include "../../system/SoC.h"
+#include "../../driver/EEPROM.h"
+#include "FISB.h"
+
+#include <fec.h>
+
+uint32_t fisb_uplinks_counter = 0;
+uint32_t fisb_uplinks_lost    = 0;
+uint32_t fisb_uplinks_failed  = 0;
+uint32_t fisb_apdus_counter   = 0;
+uint32_t fisb_apdus_lost      = 0;
+
+/*
+ * Uplink frames go from the main loop to a pool of decoder threads,
+ * one frame per thread at a time. Decoded APDUs come back through
+ * a second ring. Both rings are bounded, overflow is counted and dropped.
+ */
+static fisb_uplink_t FISB_UplinkQueue[FISB_UPLINK_QUEUE_SIZE];
+static unsigned int FISB_UplinkQueue_Head = 0;
+static unsigned int FISB_UplinkQueue_Tail = 0;
+static pthread_mutex_t FISB_Uplink_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  FISB_Uplink_cond  = PTHREAD_COND_INITIALIZER;
+
+static fisb_apdu_item_t FISB_APDUQueue[FISB_APDU_QUEUE_SIZE];
+static unsigned int FISB_APDUQueue_Head = 0;
+static unsigned int FISB_APDUQueue_Tail = 0;
+static pthread_mutex_t FISB_APDU_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t FISB_Workers[FISB_MAX_WORKERS];
+static int FISB_Worker_Count = 0;
+static bool FISB_stop = false;
+
+static void FISB_Enqueue(const struct uat_uplink_mdb *mdb,
+                         const struct fisb_apdu *apdu, time_t time)
+{
+  pthread_mutex_lock(&FISB_APDU_mutex);
+
+  if (FISB_APDUQueue_Head - FISB_APDUQueue_Tail >= FISB_APDU_QUEUE_SIZE) {
+    fisb_apdus_lost++;
+  } else {
+    fisb_apdu_item_t *item =
+      &FISB_APDUQueue[FISB_APDUQueue_Head % FISB_APDU_QUEUE_SIZE];
+    uint16_t length = apdu->length;
+
+    if (length > sizeof(item->payload)) {
+      length = sizeof(item->payload);
+    }
+
+    item->time         = time;
+    item->gs_lat       = mdb->lat;
+    item->gs_lon       = mdb->lon;
+    item->tisb_site_id = mdb->tisb_site_id;
+    item->apdu         = *apdu;
+    item->apdu.length  = length;
+    item->apdu.data    = item->payload;
+    memcpy(item->payload, apdu->data, length);
+
+    FISB_APDUQueue_Head++;
+    fisb_apdus_counter++;
+  }
+
+  pthread_mutex_unlock(&FISB_APDU_mutex);
+}
+
+static void *FISB_Worker(void *)
+{
+  fisb_uplink_t uplink;
+  uint8_t corrected[UPLINK_FRAME_BYTES];
+  struct uat_uplink_mdb mdb;
+  int rs_errors;
+
+  while (true) {
+    pthread_mutex_lock(&FISB_Uplink_mutex);
+    while (FISB_UplinkQueue_Head == FISB_UplinkQueue_Tail && !FISB_stop) {
+      pthread_cond_wait(&FISB_Uplink_cond, &FISB_Uplink_mutex);
+    }
+    if (FISB_stop) {
+      pthread_mutex_unlock(&FISB_Uplink_mutex);
+      break;
+    }
+    uplink = FISB_UplinkQueue[FISB_UplinkQueue_Tail % FISB_UPLINK_QUEUE_SIZE];
+    FISB_UplinkQueue_Tail++;
+    pthread_mutex_unlock(&FISB_Uplink_mutex);
+
+    if (uplink.corrected) {
+      memcpy(corrected, uplink.data, UPLINK_FRAME_DATA_BYTES);
+    } else if (correct_uplink_frame(uplink.data, corrected, &rs_errors) < 0) {
+      pthread_mutex_lock(&FISB_APDU_mutex);
+      fisb_uplinks_failed++;
+      pthread_mutex_unlock(&FISB_APDU_mutex);
+      continue;
+    }
+
+    uat_decode_uplink_mdb(corrected, &mdb);
+
+    if (!mdb.app_data_valid) {
+      continue;
+    }
+
+    for (unsigned i = 0; i < mdb.num_info_frames; i++) {
+      if (mdb.info_frames[i].is_fisb) {
+        FISB_Enqueue(&mdb, &mdb.info_frames[i].fisb, uplink.time);
+      }
+    }
+  }
+
+  return NULL;
+}
+
+void FISB_setup()
+{
+  if (FISB_Worker_Count > 0) {
+    return;
+  }
+
+  init_fec();
+
+  /* leave a core to the main loop */
+  long cores = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  int workers = cores < 1 ? 1 :
+                cores > FISB_MAX_WORKERS ? FISB_MAX_WORKERS : (int) cores;
+
+  FISB_stop = false;
+
+  for (int i = 0; i < workers; i++) {
+    if (pthread_create(&FISB_Workers[FISB_Worker_Count], NULL,
+                       FISB_Worker, NULL) != 0) {
+      fprintf( stderr, "pthread_create(FISB_Worker) Failed\n\n" );
+      break;
+    }
+    FISB_Worker_Count++;
+  }
+}
+
+/*
+ * Queue an uplink frame for decoding:
+ * UPLINK_FRAME_BYTES as received (interleaved, with parity), or
+ * UPLINK_FRAME_DATA_BYTES already corrected (e.g. by dump978).
+ */
+bool FISB_Uplink(const uint8_t *data, size_t size, time_t time)
+{
+  bool success = false;
+
+  if (size != UPLINK_FRAME_BYTES && size != UPLINK_FRAME_DATA_BYTES) {
+    return success;
+  }
+
+  pthread_mutex_lock(&FISB_Uplink_mutex);
+
+  if (FISB_Worker_Count == 0 ||
+      FISB_UplinkQueue_Head - FISB_UplinkQueue_Tail >= FISB_UPLINK_QUEUE_SIZE) {
+    fisb_uplinks_lost++;
+  } else {
+    fisb_uplink_t *uplink =
+      &FISB_UplinkQueue[FISB_UplinkQueue_Head % FISB_UPLINK_QUEUE_SIZE];
+
+    uplink->time      = time;
+    uplink->corrected = (size == UPLINK_FRAME_DATA_BYTES);
+    memcpy(uplink->data, data, size);
+
+    FISB_UplinkQueue_Head++;
+    fisb_uplinks_counter++;
+    success = true;
+
+    pthread_cond_signal(&FISB_Uplink_cond);
+  }
+
+  pthread_mutex_unlock(&FISB_Uplink_mutex);
+
+  return success;
+}
+
+static int hex_nibble(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/* Uplink in dump978 text form, the part after '+' up to ';' */
+bool FISB_Uplink_Hex(const char *str, size_t len, time_t time)
+{
+  uint8_t data[UPLINK_FRAME_BYTES];
+  size_t size = 0;
+
+  for (size_t i = 0; i + 1 < len && str[i] != ';'; i += 2) {
+    int hi = hex_nibble(str[i]);
+    int lo = hex_nibble(str[i + 1]);
+
+    if (hi < 0 || lo < 0 || size >= sizeof(data)) {
+      return false;
+    }
+    data[size++] = (hi << 4) | lo;
+  }
+
+  return FISB_Uplink(data, size, time);
+}
+
+/* Take the oldest decoded APDU, if any */
+bool FISB_Dequeue(fisb_apdu_item_t *item)
+{
+  bool success = false;
+
+  pthread_mutex_lock(&FISB_APDU_mutex);
+
+  if (FISB_APDUQueue_Tail != FISB_APDUQueue_Head) {
+    *item = FISB_APDUQueue[FISB_APDUQueue_Tail % FISB_APDU_QUEUE_SIZE];
+    item->apdu.data = item->payload;
+    FISB_APDUQueue_Tail++;
+    success = true;
+  }
+
+  pthread_mutex_unlock(&FISB_APDU_mutex);
+
+  return success;
+}
+
+/*
+ * Product store, main loop only.
+ * Every change takes the next sequence number, so that a consumer
+ * only has to keep the last number it has seen to get the deltas.
+ */
+static fisb_product_t FISB_Products[FISB_PRODUCTS_MAX];
+static fisb_tile_t    FISB_Tiles[FISB_TILES_MAX];
+static uint8_t        FISB_Assembly[FISB_PRODUCT_MAX_BYTES];
+static uint32_t       FISB_seq = 0;
+static time_t         FISB_Expire_Time = 0;
+
+uint32_t fisb_products_lost = 0;
+uint32_t fisb_tiles_lost    = 0;
+
+uint32_t FISB_Seq()
+{
+  return FISB_seq;
+}
+
+/* Ground station time stamp of an APDU, on the day of its reception */
+static time_t FISB_Time(const fisb_apdu_item_t *item)
+{
+  tmElements_t tm;
+  time_t t;
+
+  breakTime(item->time, tm);
+  if (item->apdu.monthday_valid) {
+    tm.Month = item->apdu.month;
+    tm.Day   = item->apdu.day;
+  }
+  tm.Hour   = item->apdu.hours;
+  tm.Minute = item->apdu.minutes;
+  tm.Second = item->apdu.seconds_valid ? item->apdu.seconds : 0;
+
+  t = makeTime(tm);
+
+  /* stamped before midnight, received after */
+  if (!item->apdu.monthday_valid && t > item->time + (time_t) SECS_PER_DAY / 2) {
+    t -= SECS_PER_DAY;
+  }
+
+  return t;
+}
+
+static unsigned int FISB_Tile_Home(uint32_t key)
+{
+  return ((key * 2654435761U) >> 16) & (FISB_TILES_MAX - 1);
+}
+
+static fisb_tile_t *FISB_Tile_Slot(uint32_t key)
+{
+  unsigned int idx = FISB_Tile_Home(key);
+
+  for (unsigned int n = 0; n < FISB_TILES_MAX; n++) {
+    fisb_tile_t *tile = &FISB_Tiles[idx];
+
+    if (tile->state == FISB_TILE_FREE || tile->key == key) {
+      return tile;
+    }
+    idx = (idx + 1) & (FISB_TILES_MAX - 1);
+  }
+
+  return NULL;
+}
+
+/* backward shift deletion, no tombstones are left behind */
+static void FISB_Tile_Remove(unsigned int i)
+{
+  unsigned int j = i;
+
+  for (;;) {
+    j = (j + 1) & (FISB_TILES_MAX - 1);
+    if (FISB_Tiles[j].state == FISB_TILE_FREE) {
+      break;
+    }
+
+    unsigned int k = FISB_Tile_Home(FISB_Tiles[j].key);
+
+    /* move the tile into the hole unless its home slot is within (i, j] */
+    if ((i <= j) ? (i >= k || k > j) : (i >= k && k > j)) {
+      FISB_Tiles[i] = FISB_Tiles[j];
+      i = j;
+    }
+  }
+
+  FISB_Tiles[i].state   = FISB_TILE_FREE;
+  FISB_Tiles[i].rle_len = 0;
+}
+
+static void FISB_Tile_Update(uint32_t key, uint8_t state,
+                             const uint8_t *rle, size_t len,
+                             time_t time, time_t expires)
+{
+  fisb_tile_t *tile = FISB_Tile_Slot(key);
+
+  if (tile == NULL) {
+    fisb_tiles_lost++;
+    return;
+  }
+
+  bool fresh = (tile->state == FISB_TILE_FREE);
+
+  if (!fresh && time < tile->time) {
+    return;  /* we have got a newer one */
+  }
+
+  if (len > FISB_TILE_RLE_MAX) {
+    len = FISB_TILE_RLE_MAX;
+  }
+
+  if (fresh || tile->state != state || tile->rle_len != len ||
+      memcmp(tile->rle, rle, len) != 0) {
+    tile->key     = key;
+    tile->state   = state;
+    tile->rle_len = len;
+    if (len > 0) {
+      memcpy(tile->rle, rle, len);
+    }
+    tile->seq     = ++FISB_seq;
+  }
+
+  tile->time    = time;
+  tile->expires = expires;
+}
+
+/* Bins of a tile, one intensity (0-7) per byte, 32 per row, 4 rows */
+void FISB_Tile_Bins(const fisb_tile_t *tile, uint8_t *bins)
+{
+  int x = 0;
+
+  if (tile->state == FISB_TILE_RLE) {
+    for (int i = 0; i < tile->rle_len && x < FISB_NEXRAD_BLOCK_BINS; i++) {
+      int intensity = tile->rle[i] & 0x07;
+      int runlength = (tile->rle[i] >> 3) + 1;
+
+      while (runlength-- > 0 && x < FISB_NEXRAD_BLOCK_BINS) {
+        bins[x++] = intensity;
+      }
+    }
+  }
+
+  while (x < FISB_NEXRAD_BLOCK_BINS) {
+    bins[x++] = 0;
+  }
+}
+
+/*
+ * NEXRAD APDU: one block of run-length encoded bins, or a reference block
+ * followed by a bitmap of empty blocks along the same row.
+ */
+static void FISB_Nexrad(const fisb_apdu_item_t *item, time_t time, time_t expires)
+{
+  const uint8_t *data = item->apdu.data;
+  uint16_t length = item->apdu.length;
+
+  if (length < 4) {
+    return;
+  }
+
+  bool     rle_flag  = (data[0] & 0x80) != 0;
+  uint8_t  ns_flag   = (data[0] & 0x40) ? 1 : 0;
+  uint8_t  scale     = (data[0] & 0x30) >> 4;
+  uint32_t block_num = ((data[0] & 0x0f) << 16) | (data[1] << 8) | data[2];
+  uint16_t product   = item->apdu.product_id;
+
+  if (rle_flag) {
+    FISB_Tile_Update(FISB_TILE_KEY(product, ns_flag, scale, block_num),
+                     FISB_TILE_RLE, data + 3, length - 3, time, expires);
+    return;
+  }
+
+  /* 450 blocks a row up to 60 degrees, 225 above */
+  uint32_t row_size  = block_num < 405000 ? 450 : 225;
+  uint32_t row_start = block_num < 405000 ? block_num - block_num % 450 :
+                       block_num - (block_num - 405000) % 225;
+  int L = data[3] & 0x0f;
+
+  for (int i = 0; i < L && 3 + i < length; i++) {
+    /* bit 3 of the first byte stands for the reference block itself */
+    uint8_t bb = (i == 0) ? ((data[3] & 0xf0) | 0x08) : data[3 + i];
+
+    for (int j = 0; j < 8; j++) {
+      if (bb & (1 << j)) {
+        uint32_t n = block_num + 8 * i + j - 3;
+
+        if (n >= row_start && n < row_start + row_size) {
+          FISB_Tile_Update(FISB_TILE_KEY(product, ns_flag, scale, n),
+                           FISB_TILE_EMPTY, NULL, 0, time, expires);
+        }
+      }
+    }
+  }
+}
+
+static fisb_product_t *FISB_Product_Slot(uint16_t product_id, uint16_t region,
+                                         time_t time)
+{
+  fisb_product_t *victim = &FISB_Products[0];
+
+  for (int i = 0; i < FISB_PRODUCTS_MAX; i++) {
+    fisb_product_t *prod = &FISB_Products[i];
+
+    if (prod->product_id == product_id && prod->region == region &&
+        prod->time == time && prod->expires) {
+      return prod;
+    }
+    /* free, expired, or else the one to expire first */
+    if (victim->product_id != 0 && victim->expires != 0 &&
+        (prod->product_id == 0 || prod->expires < victim->expires)) {
+      victim = prod;
+    }
+  }
+
+  memset(victim, 0, offsetof(fisb_product_t, data));
+  victim->product_id = product_id;
+  victim->region     = region;
+  victim->time       = time;
+
+  return victim;
+}
+
+static void FISB_Product_Update(const fisb_apdu_item_t *item, time_t time, time_t expires)
+{
+  const uint8_t *data = item->apdu.data;
+  uint16_t length   = item->apdu.length;
+  uint16_t region   = item->tisb_site_id;
+  uint16_t segments = 0;
+  uint16_t segment  = 0;
+
+  if (item->apdu.s_flag) {
+    /* Product File ID (10 bits), Product File Length (9), APDU Number (9) */
+    if (length < 4) {
+      return;
+    }
+    region   = (data[0] << 2) | (data[1] >> 6);
+    segments = ((data[1] & 0x3f) << 3) | (data[2] >> 5);
+    segment  = ((data[2] & 0x1f) << 4) | (data[3] >> 4);
+    data   += 4;
+    length -= 4;
+
+    if (segment < 1 || segment > segments || segments > FISB_PRODUCT_MAX_SEGS) {
+      fisb_products_lost++;
+      return;
+    }
+  }
+
+  fisb_product_t *prod = FISB_Product_Slot(item->apdu.product_id, region, time);
+
+  prod->expires = expires;
+
+  if (segments == 0) {
+    if (length > sizeof(prod->data)) {
+      fisb_products_lost++;
+      return;
+    }
+    if (prod->complete && prod->length == length &&
+        memcmp(prod->data, data, length) == 0) {
+      return;  /* a repeat */
+    }
+    memcpy(prod->data, data, length);
+    prod->length   = length;
+    prod->complete = true;
+    prod->seq      = ++FISB_seq;
+    return;
+  }
+
+  uint16_t bit = 1 << (segment - 1);
+
+  if (prod->segments != segments) {
+    prod->segments = segments;
+    prod->received = 0;
+    prod->length   = 0;
+    prod->complete = false;
+  }
+
+  if (prod->received & bit) {
+    return;  /* a repeat */
+  }
+
+  if (prod->length + length > sizeof(prod->data)) {
+    fisb_products_lost++;
+    return;
+  }
+
+  /* segments are stored as they come in, put in order once all are here */
+  prod->seg_off[segment - 1] = prod->length;
+  prod->seg_len[segment - 1] = length;
+  memcpy(prod->data + prod->length, data, length);
+  prod->length   += length;
+  prod->received |= bit;
+
+  if (prod->received == (uint16_t) ((1UL << segments) - 1)) {
+    uint16_t offset = 0;
+
+    for (int i = 0; i < segments; i++) {
+      memcpy(FISB_Assembly + offset, prod->data + prod->seg_off[i], prod->seg_len[i]);
+      offset += prod->seg_len[i];
+    }
+    memcpy(prod->data, FISB_Assembly, offset);
+
+    prod->complete = true;
+    prod->seq      = ++FISB_seq;
+  }
+}
+
+/* Put a decoded APDU into the store */
+void FISB_Store(const fisb_apdu_item_t *item)
+{
+  time_t time = FISB_Time(item);
+  uint16_t product_id = item->apdu.product_id;
+
+  switch (product_id)
+  {
+  case FISB_PRODUCT_NEXRAD_REGIONAL:
+    if (time + FISB_NEXRAD_REGIONAL_TTL > item->time) {
+      FISB_Nexrad(item, time, time + FISB_NEXRAD_REGIONAL_TTL);
+    }
+    break;
+  case FISB_PRODUCT_NEXRAD_CONUS:
+    if (time + FISB_NEXRAD_CONUS_TTL > item->time) {
+      FISB_Nexrad(item, time, time + FISB_NEXRAD_CONUS_TTL);
+    }
+    break;
+  default:
+    if (time + FISB_PRODUCT_TTL > item->time) {
+      FISB_Product_Update(item, time, time + FISB_PRODUCT_TTL);
+    }
+    break;
+  }
+}
+
+/*
+ * Expired tiles are reported as cleared for FISB_TILE_LINGER seconds,
+ * expired products once, with expires set to 0.
+ */
+void FISB_Expire(time_t this_moment)
+{
+  for (int i = 0; i < FISB_TILES_MAX; i++) {
+    fisb_tile_t *tile = &FISB_Tiles[i];
+
+    /* another tile may be shifted into its place, that one is looked at too */
+    while (tile->state == FISB_TILE_GONE && tile->expires <= this_moment) {
+      FISB_Tile_Remove(i);
+    }
+
+    if (tile->state == FISB_TILE_RLE || tile->state == FISB_TILE_EMPTY) {
+      if (tile->expires <= this_moment) {
+        tile->state   = FISB_TILE_GONE;
+        tile->rle_len = 0;
+        tile->expires = this_moment + FISB_TILE_LINGER;
+        tile->seq     = ++FISB_seq;
+      }
+    }
+  }
+
+  for (int i = 0; i < FISB_PRODUCTS_MAX; i++) {
+    fisb_product_t *prod = &FISB_Products[i];
+
+    if (prod->product_id && prod->expires && prod->expires <= this_moment) {
+      bool was_complete = prod->complete;
+
+      prod->expires  = 0;
+      prod->complete = false;
+      prod->length   = 0;
+      if (was_complete) {
+        prod->seq = ++FISB_seq;
+      }
+    }
+  }
+}
+
+/* Tiles changed after sequence number 'since', *cursor starts at 0 */
+const fisb_tile_t *FISB_Tile_Next(uint32_t since, unsigned int *cursor)
+{
+  while (*cursor < FISB_TILES_MAX) {
+    const fisb_tile_t *tile = &FISB_Tiles[(*cursor)++];
+
+    if (tile->state != FISB_TILE_FREE && tile->seq > since) {
+      return tile;
+    }
+  }
+
+  return NULL;
+}
+
+/* Products completed or expired after sequence number 'since' */
+const fisb_product_t *FISB_Product_Next(uint32_t since, unsigned int *cursor)
+{
+  while (*cursor < FISB_PRODUCTS_MAX) {
+    const fisb_product_t *prod = &FISB_Products[(*cursor)++];
+
+    if (prod->product_id && prod->seq > since &&
+        (prod->complete || prod->expires == 0)) {
+      return prod;
+    }
+  }
+
+  return NULL;
+}
+
+void FISB_loop()
+{
+  fisb_apdu_item_t item;
+  time_t this_moment = now();
+
+  for (int i = 0; i < FISB_APDU_QUEUE_SIZE && FISB_Dequeue(&item); i++) {
+    FISB_Store(&item);
+
+    if (settings->nmea_p) {
+      StdOut.print(F("$PSRFU,"));
+      StdOut.print((unsigned long) item.time); StdOut.print(F(","));
+      StdOut.print(item.apdu.product_id); StdOut.print(F(","));
+      StdOut.println(item.apdu.length);
+    }
+  }
+
+  if (this_moment != FISB_Expire_Time) {
+    FISB_Expire(this_moment);
+    FISB_Expire_Time = this_moment;
+  }
+}
+
+void FISB_fini()
+{
+  pthread_mutex_lock(&FISB_Uplink_mutex);
+  FISB_stop = true;
+  pthread_cond_broadcast(&FISB_Uplink_cond);
+  pthread_mutex_unlock(&FISB_Uplink_mutex);
+
+  for (int i = 0; i < FISB_Worker_Count; i++) {
+    pthread_join(FISB_Workers[i], NULL);
+  }
+  FISB_Worker_Count = 0;
+}
+
+#endif /* RASPBERRY_PI */
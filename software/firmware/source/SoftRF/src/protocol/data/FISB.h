@@ -0,0 +1,123 @@
+/*
+ * FISBHelper.h
+ * Copyright (C) 2021 Linar Yusupov
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FISBHELPER_H
+#define FISBHELPER_H
+
+#include <uat.h>
+#include <uat_decode.h>
+
+/* uplink frames waiting for a decoder thread, power of 2 */
+#define FISB_UPLINK_QUEUE_SIZE  16
+/* decoded APDUs waiting for the main loop, power of 2 */
+#define FISB_APDU_QUEUE_SIZE    64
+/* decoder threads, no more than CPU cores */
+#define FISB_MAX_WORKERS        4
+
+/* product store */
+#define FISB_PRODUCTS_MAX       64
+#define FISB_PRODUCT_MAX_BYTES  2048
+#define FISB_PRODUCT_MAX_SEGS   16
+/* NEXRAD tile grid, power of 2 */
+#define FISB_TILES_MAX          4096
+#define FISB_TILE_RLE_MAX       128
+/* seconds an expired tile stays around to be reported as cleared */
+#define FISB_TILE_LINGER        60
+
+#define FISB_PRODUCT_NEXRAD_REGIONAL  63
+#define FISB_PRODUCT_NEXRAD_CONUS     64
+
+/* validity of products, seconds after their time stamp */
+#define FISB_NEXRAD_REGIONAL_TTL  (10 * 60)
+#define FISB_NEXRAD_CONUS_TTL     (30 * 60)
+#define FISB_PRODUCT_TTL          (60 * 60)
+
+/* NEXRAD block: 32 x 4 bins, 3 bit intensity */
+#define FISB_NEXRAD_BLOCK_BINS  128
+
+typedef struct fisb_uplink_struct {
+  time_t        time;       /* reception */
+  bool          corrected;  /* data is de-interleaved and FEC corrected */
+  uint8_t       data[UPLINK_FRAME_BYTES];
+} fisb_uplink_t;
+
+typedef struct fisb_apdu_item_struct {
+  time_t        time;       /* reception of the uplink frame */
+  float         gs_lat;     /* ground station */
+  float         gs_lon;
+  uint8_t       tisb_site_id;
+  struct fisb_apdu apdu;    /* apdu.data points to payload */
+  uint8_t       payload[sizeof(((struct uat_uplink_mdb *) 0)->app_data)];
+} fisb_apdu_item_t;
+
+enum
+{
+  FISB_TILE_FREE,
+  FISB_TILE_RLE,      /* rle[] holds the bins as run-length encoded on air */
+  FISB_TILE_EMPTY,    /* no precipitation */
+  FISB_TILE_GONE      /* expired, to be reported once as cleared */
+};
+
+/* (product, north/south, scale, block number) of a NEXRAD block */
+#define FISB_TILE_KEY(p, ns, sf, blk) \
+  ((uint32_t) ((p) == FISB_PRODUCT_NEXRAD_CONUS) << 23 | \
+   (uint32_t) (ns) << 22 | (uint32_t) (sf) << 20 | ((blk) & 0xFFFFF))
+
+typedef struct fisb_tile_struct {
+  uint32_t      key;        /* FISB_TILE_KEY() */
+  uint8_t       state;
+  uint8_t       rle_len;
+  time_t        time;       /* as stamped by the ground station */
+  time_t        expires;
+  uint32_t      seq;        /* FISB_Seq() at the last change */
+  uint8_t       rle[FISB_TILE_RLE_MAX];
+} fisb_tile_t;
+
+typedef struct fisb_product_struct {
+  uint16_t      product_id; /* 0 for a free slot */
+  uint16_t      region;     /* product file ID if segmented, TIS-B site ID if not */
+  time_t        time;       /* as stamped by the ground station */
+  time_t        expires;    /* 0 once expired */
+  uint32_t      seq;        /* FISB_Seq() at the last change */
+  bool          complete;
+  uint16_t      segments;   /* total number, 0 if not segmented */
+  uint16_t      received;   /* bitmap of segments in */
+  uint16_t      seg_off[FISB_PRODUCT_MAX_SEGS];
+  uint16_t      seg_len[FISB_PRODUCT_MAX_SEGS];
+  uint16_t      length;
+  uint8_t       data[FISB_PRODUCT_MAX_BYTES];
+} fisb_product_t;
+
+void FISB_setup(void);
+void FISB_loop(void);
+void FISB_fini(void);
+bool FISB_Uplink(const uint8_t *, size_t, time_t);
+bool FISB_Uplink_Hex(const char *, size_t, time_t);
+bool FISB_Dequeue(fisb_apdu_item_t *);
+void FISB_Store(const fisb_apdu_item_t *);
+void FISB_Expire(time_t);
+uint32_t FISB_Seq(void);
+const fisb_tile_t *FISB_Tile_Next(uint32_t, unsigned int *);
+const fisb_product_t *FISB_Product_Next(uint32_t, unsigned int *);
+void FISB_Tile_Bins(const fisb_tile_t *, uint8_t *);
+
+extern uint32_t fisb_uplinks_counter, fisb_uplinks_lost, fisb_uplinks_failed;
+extern uint32_t fisb_apdus_counter, fisb_apdus_lost;
+extern uint32_t fisb_products_lost, fisb_tiles_lost;
+
+#endif /* FISBHELPER_H */
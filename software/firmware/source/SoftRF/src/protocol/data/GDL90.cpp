@@ -20,7 +20,7 @@
  */
 
 #include <TimeLib.h>
-#include <lib_crc.h>
+#include <crc_fast.h>
 #include <protocol.h>
 
 #include "../../system/SoC.h"
@@ -32,6 +32,10 @@
 #include "../radio/Legacy.h"
 #include "NMEA.h"
 
+#if defined(RASPBERRY_PI)
+#include "FISB.h"
+#endif /* RASPBERRY_PI */
+
 #if defined(ENABLE_AHRS)
 #include "../../AHRS.h"
 #endif /* ENABLE_AHRS */
@@ -157,14 +161,10 @@ static uint32_t pack24bit(uint32_t num)
 
 uint16_t GDL90_calcFCS(uint8_t msg_id, uint8_t *msg, int size)
 {
-  uint16_t crc16 = 0x0000;  /* seed value */
-
-  crc16 = update_crc_gdl90(crc16, msg_id);
+  uint16_t crc16 = CRC16_GDL90_SEED;
 
-  for (int i=0; i < size; i++)
-  {
-    crc16 = update_crc_gdl90(crc16, msg[i]);
-  }    
+  crc16 = crc16_gdl90(crc16, &msg_id, 1);
+  crc16 = crc16_gdl90(crc16, msg, size);
 
   return(crc16);
 }
@@ -286,8 +286,10 @@ static void *msgType10and20(ufo_t *aircraft)
    * If it is not - generate a callsign substitute,
    * based upon a protocol ID and the ICAO address
    */
-  if (strnlen((char *) aircraft->callsign, sizeof(aircraft->callsign)) > 0) {
-    memcpy(Traffic.callsign, aircraft->callsign, sizeof(Traffic.callsign));
+  ufo_cold_t *cold = Traffic_Cold(aircraft);
+
+  if (strnlen((char *) cold->callsign, sizeof(cold->callsign)) > 0) {
+    memcpy(Traffic.callsign, cold->callsign, sizeof(Traffic.callsign));
   } else {
     memcpy((char *)Traffic.callsign, GDL90_CallSign_Prefix[aircraft->protocol],
       strlen(GDL90_CallSign_Prefix[aircraft->protocol]));
@@ -464,6 +466,191 @@ static void GDL90_Out(byte *buf, size_t size)
   }
 }
 
+#if defined(RASPBERRY_PI)
+
+/*
+ * FIS-B products are re-sent to the EFB as Uplink Data messages
+ * which only carry what has changed in the store since the last export.
+ * Every GDL90_FISB_REFRESH_MS the whole store is sent again, so that an EFB
+ * connected late, or one which has missed a datagram, catches up.
+ */
+#define GDL90_FISB_REFRESH_MS   (2 * 60 * 1000) /* 2 minutes */
+
+static uint32_t GDL90_FISB_seq    = 0;
+static unsigned long GDL90_FISB_Refresh_ms = 0;
+static size_t   GDL90_Uplink_size = 0;
+static uint8_t  GDL90_Uplink[GDL90_UPLINK_MSG_SIZE];
+static uint8_t  GDL90_Uplink_buf[2 * (GDL90_UPLINK_MSG_SIZE + 3) + 2];
+
+static void GDL90_Uplink_Reset()
+{
+  memset(GDL90_Uplink, 0, sizeof(GDL90_Uplink));
+
+  /* Time of Reception is not available */
+  GDL90_Uplink[0] = GDL90_Uplink[1] = GDL90_Uplink[2] = 0xFF;
+  /* UAT-specific header: no position, UTC coupled, app data valid */
+  GDL90_Uplink[3 + 6] = 0x80 | 0x20;
+
+  GDL90_Uplink_size = 3 + 8;
+}
+
+static void GDL90_Uplink_Flush()
+{
+  uint8_t *ptr = GDL90_Uplink_buf;
+  uint16_t fcs;
+  uint8_t fcs_lsb, fcs_msb;
+
+  if (GDL90_Uplink_size <= 3 + 8) {
+    return;
+  }
+
+  fcs = GDL90_calcFCS(GDL90_UPLINK_MSG_ID, GDL90_Uplink, sizeof(GDL90_Uplink));
+  fcs_lsb = fcs        & 0xFF;
+  fcs_msb = (fcs >> 8) & 0xFF;
+
+  *ptr++ = 0x7E; /* Start flag */
+  *ptr++ = GDL90_UPLINK_MSG_ID;
+  ptr = GDL90_EscapeFilter(ptr, GDL90_Uplink, sizeof(GDL90_Uplink));
+  ptr = GDL90_EscapeFilter(ptr, &fcs_lsb, 1);
+  ptr = GDL90_EscapeFilter(ptr, &fcs_msb, 1);
+  *ptr++ = 0x7E; /* Stop flag */
+
+  GDL90_Out(GDL90_Uplink_buf, ptr - GDL90_Uplink_buf);
+
+  GDL90_Uplink_Reset();
+}
+
+/* APDU bytes that fit into one information frame, header included */
+#define GDL90_UPLINK_APDU_MAX   (GDL90_UPLINK_MSG_SIZE - 3 - 8 - 2)
+
+/* append one information frame with a FIS-B APDU */
+static bool GDL90_Uplink_APDU(uint16_t product_id, time_t time, bool segmented,
+                              const uint8_t *hdr, size_t hdr_len,
+                              const uint8_t *data, size_t len)
+{
+  size_t apdu_len  = 4 + hdr_len + len;
+  size_t frame_len = 2 + apdu_len;
+  uint8_t *ptr;
+
+  if (apdu_len > GDL90_UPLINK_APDU_MAX) {
+    return false;
+  }
+  if (GDL90_Uplink_size + frame_len > sizeof(GDL90_Uplink)) {
+    GDL90_Uplink_Flush();
+  }
+
+  ptr = GDL90_Uplink + GDL90_Uplink_size;
+
+  /* frame header: 9 bits of length, frame type 0 (FIS-B APDU) */
+  ptr[0] = apdu_len >> 1;
+  ptr[1] = (apdu_len & 1) << 7;
+
+  /* APDU header: no A/G/P flags, time option 0 (hours and minutes) */
+  ptr[2] = (product_id >> 6) & 0x1F;
+  ptr[3] = (product_id & 0x3F) << 2 | (segmented ? 0x02 : 0x00);
+  ptr[4] = (hour(time) << 2) | (minute(time) >> 4);
+  ptr[5] = (minute(time) & 0x0F) << 4;
+
+  if (hdr_len > 0) {
+    memcpy(ptr + 6, hdr, hdr_len);
+  }
+  if (len > 0) {
+    memcpy(ptr + 6 + hdr_len, data, len);
+  }
+
+  GDL90_Uplink_size += frame_len;
+
+  return true;
+}
+
+/* a product that is too large for one APDU goes out in segments */
+static void GDL90_Uplink_Product(const fisb_product_t *prod)
+{
+  const size_t seg_max = GDL90_UPLINK_APDU_MAX - 4 - 4;
+  uint16_t segments = (prod->length + seg_max - 1) / seg_max;
+
+  if (GDL90_Uplink_APDU(prod->product_id, prod->time, false, NULL, 0,
+                        prod->data, prod->length)) {
+    return;
+  }
+
+  if (segments > FISB_PRODUCT_MAX_SEGS) {
+    fisb_products_lost++;
+    return;
+  }
+
+  for (uint16_t segment = 1; segment <= segments; segment++) {
+    size_t offset = (segment - 1) * seg_max;
+    size_t len    = prod->length - offset < seg_max ?
+                    prod->length - offset : seg_max;
+    uint8_t hdr[4];
+
+    /* Product File ID (10 bits), Product File Length (9), APDU Number (9) */
+    hdr[0] = (prod->region >> 2) & 0xFF;
+    hdr[1] = (prod->region & 0x03) << 6 | (segments >> 3);
+    hdr[2] = (segments & 0x07) << 5 | (segment >> 4);
+    hdr[3] = (segment & 0x0F) << 4;
+
+    GDL90_Uplink_APDU(prod->product_id, prod->time, true, hdr, sizeof(hdr),
+                      prod->data + offset, len);
+  }
+}
+
+static void GDL90_FISB_Export()
+{
+  uint32_t seq = FISB_Seq();
+  unsigned int cursor;
+  const fisb_tile_t *tile;
+  const fisb_product_t *prod;
+
+  if (millis() - GDL90_FISB_Refresh_ms > GDL90_FISB_REFRESH_MS) {
+    GDL90_FISB_seq = 0;
+    GDL90_FISB_Refresh_ms = millis();
+  }
+
+  if (seq == GDL90_FISB_seq) {
+    return;
+  }
+
+  GDL90_Uplink_Reset();
+
+  cursor = 0;
+  while ((tile = FISB_Tile_Next(GDL90_FISB_seq, &cursor)) != NULL) {
+    uint8_t  ref[4];
+    uint32_t blk = tile->key & 0xFFFFF;
+    uint16_t product_id = (tile->key >> 23) & 1 ? FISB_PRODUCT_NEXRAD_CONUS :
+                                                  FISB_PRODUCT_NEXRAD_REGIONAL;
+
+    ref[0] = (tile->state == FISB_TILE_RLE ? 0x80 : 0x00) |
+             ((tile->key >> 22) & 1) << 6 | ((tile->key >> 20) & 3) << 4 |
+             (blk >> 16);
+    ref[1] = (blk >> 8) & 0xFF;
+    ref[2] =  blk       & 0xFF;
+
+    if (tile->state == FISB_TILE_RLE) {
+      GDL90_Uplink_APDU(product_id, tile->time, false, ref, 3,
+                        tile->rle, tile->rle_len);
+    } else {
+      /* empty or cleared: this block only, no bitmap */
+      ref[3] = 0x01;
+      GDL90_Uplink_APDU(product_id, tile->time, false, ref, 4, NULL, 0);
+    }
+  }
+
+  cursor = 0;
+  while ((prod = FISB_Product_Next(GDL90_FISB_seq, &cursor)) != NULL) {
+    if (prod->expires && prod->complete) {
+      GDL90_Uplink_Product(prod);
+    }
+  }
+
+  GDL90_Uplink_Flush();
+
+  GDL90_FISB_seq = seq;
+}
+
+#endif /* RASPBERRY_PI */
+
 void GDL90_Export()
 {
   size_t size;
@@ -493,18 +680,24 @@ void GDL90_Export()
       size = makeGeometricAltitude(buf, &ThisAircraft);
       GDL90_Out(buf, size);
 
-      for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-        if (Container[i].addr &&
-           (this_moment - Container[i].timestamp) <= EXPORT_EXPIRATION_TIME) {
+      for (int i=0; i < Traffic_Count(); i++) {
+        ufo_t *fop = Traffic_Entry(i);
 
-          distance = Container[i].distance;
+        if (fop->addr &&
+           (this_moment - fop->timestamp) <= EXPORT_EXPIRATION_TIME) {
+
+          distance = fop->distance;
 
           if (distance < ALARM_ZONE_NONE) {
-            size = makeTrafficReport(buf, &Container[i]);
+            size = makeTrafficReport(buf, fop);
             GDL90_Out(buf, size);
           }
         }
       }
     }
+
+#if defined(RASPBERRY_PI)
+    GDL90_FISB_Export();
+#endif /* RASPBERRY_PI */
   }
 }
@@ -93,6 +93,10 @@ typedef struct GDL90_Msg_HeartBeat {
 #define GDL90_OWNSHIP_MSG_ID  10
 #define GDL90_TRAFFIC_MSG_ID  20
 
+#define GDL90_UPLINK_MSG_ID   7
+/* Time of Reception (3) + UAT uplink payload (432) */
+#define GDL90_UPLINK_MSG_SIZE 435
+
 typedef struct GDL90_Msg_Traffic {
 
   unsigned int addr_type:4;
@@ -164,4 +168,4 @@ void GDL90_Export(void);
 uint16_t GDL90_calcFCS(uint8_t, uint8_t *, int);
 uint8_t *GDL90_EscapeFilter(uint8_t *, uint8_t *, int);
 
-#endif /* GDL90HELPER_H */
\ No newline at end of file
+#endif /* GDL90HELPER_H */
\ No newline at end of file
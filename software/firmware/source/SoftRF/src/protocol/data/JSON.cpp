@@ -59,6 +59,12 @@ byte getVal(char c)
      return (byte)(toupper(c)-'A'+10);
 }
 
+#if defined(USE_TRAFFIC_SNAPSHOT)
+/* the exporter thread works on its own copy of the traffic table */
+static StaticJsonBuffer<JSON_BUFFER_SIZE> JSON_Export_Buffer;
+static traffic_snapshot_t JSON_Snapshot;
+#endif /* USE_TRAFFIC_SNAPSHOT */
+
 void JSON_Export()
 {
   if (settings->json != JSON_PING) {
@@ -66,49 +72,69 @@ void JSON_Export()
   }
 
   float distance;
-  time_t this_moment = now();
   char buffer[3 * 80 * MAX_TRACKING_OBJECTS];
   bool has_aircraft = false;
 
-  JsonObject& root = jsonBuffer.createObject();
+#if defined(USE_TRAFFIC_SNAPSHOT)
+  if (!Traffic_Snapshot_Read(&JSON_Snapshot, JSON_Snapshot.id) ||
+      !JSON_Snapshot.valid_fix) {
+    return;
+  }
+
+  time_t this_moment = JSON_Snapshot.time;
+  int count = JSON_Snapshot.count;
+  StaticJsonBuffer<JSON_BUFFER_SIZE> &json = JSON_Export_Buffer;
+#else
+  time_t this_moment = now();
+  int count = Traffic_Count();
+  StaticJsonBuffer<JSON_BUFFER_SIZE> &json = jsonBuffer;
+#endif /* USE_TRAFFIC_SNAPSHOT */
+
+  JsonObject& root = json.createObject();
   JsonArray& aircraft_array = root.createNestedArray("aircraft");
 
-  for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-    if (Container[i].addr && (this_moment - Container[i].timestamp) <= EXPORT_EXPIRATION_TIME) {
+  for (int i=0; i < count; i++) {
+#if defined(USE_TRAFFIC_SNAPSHOT)
+    ufo_t *fop = &JSON_Snapshot.entries[i];
+#else
+    ufo_t *fop = Traffic_Entry(i);
+#endif /* USE_TRAFFIC_SNAPSHOT */
 
-      distance = Container[i].distance;
+    if (fop->addr && (this_moment - fop->timestamp) <= EXPORT_EXPIRATION_TIME) {
+
+      distance = fop->distance;
 
       if (distance < ALARM_ZONE_NONE) {
 
         char hexbuf[8];
         char callsign[8+1];
         char timebuf[32];
-        time_t timestamp = now(); /* GNSS date&time */
+        time_t timestamp = this_moment; /* GNSS date&time */
 
-        snprintf(hexbuf, sizeof(hexbuf), "%06X", Container[i].addr);
+        snprintf(hexbuf, sizeof(hexbuf), "%06X", fop->addr);
 
         JsonObject& aircraft = aircraft_array.createNestedObject();
 
         aircraft["icaoAddress"] = hexbuf; // ICAO of the aircraft
         aircraft["trafficSource"] = 2; // 0 = 1090ES , 1 = UAT
-        aircraft["latDD"] = Container[i].latitude;  // Latitude expressed as decimal degrees
-        aircraft["lonDD"] = Container[i].longitude; // Longitude expressed as decimal degrees
+        aircraft["latDD"] = fop->latitude;  // Latitude expressed as decimal degrees
+        aircraft["lonDD"] = fop->longitude; // Longitude expressed as decimal degrees
         /* Geometric altitude or barometric pressure altitude in millimeters */
-        aircraft["altitudeMM"] = (long) (Container[i].altitude * 1000);
+        aircraft["altitudeMM"] = (long) (fop->altitude * 1000);
         /* Course over ground in centi-degrees */
-        aircraft["headingDE2"] = (int) (Container[i].course * 100);
+        aircraft["headingDE2"] = (int) (fop->course * 100);
         /* Horizontal velocity in centimeters/sec */
-        aircraft["horVelocityCMS"] = (unsigned long) (Container[i].speed * _GPS_MPS_PER_KNOT * 100);
+        aircraft["horVelocityCMS"] = (unsigned long) (fop->speed * _GPS_MPS_PER_KNOT * 100);
         /* Vertical velocity in centimeters/sec with positive being up */
-        aircraft["verVelocityCMS"] = (long) (Container[i].vs * 100 / (_GPS_FEET_PER_METER * 60.0));
+        aircraft["verVelocityCMS"] = (long) (fop->vs * 100 / (_GPS_FEET_PER_METER * 60.0));
         aircraft["squawk"] = (settings->band == RF_BAND_US ? 1200 : 7000); // VFR Squawk code
         aircraft["altitudeType"] = 1; // Altitude Source: 0 = Pressure 1 = Geometric
-        memcpy(callsign, GDL90_CallSign_Prefix[Container[i].protocol],
-          strlen(GDL90_CallSign_Prefix[Container[i].protocol]));
-        memcpy(callsign + strlen(GDL90_CallSign_Prefix[Container[i].protocol]),
+        memcpy(callsign, GDL90_CallSign_Prefix[fop->protocol],
+          strlen(GDL90_CallSign_Prefix[fop->protocol]));
+        memcpy(callsign + strlen(GDL90_CallSign_Prefix[fop->protocol]),
           hexbuf, strlen(hexbuf) + 1);
         aircraft["Callsign"] = callsign; // Callsign
-        aircraft["emitterType"] = AT_TO_GDL90(Container[i].aircraft_type); // Category type of the emitter
+        aircraft["emitterType"] = AT_TO_GDL90(fop->aircraft_type); // Category type of the emitter
         aircraft["utcSync"] = 1; // UTC time flag
         /* Time packet was received at the pingStation ISO 8601 format: YYYY-MM-DDTHH:mm:ss:ffffffffZ */
         strftime(timebuf, sizeof(timebuf), "%FT%T:00000000Z", gmtime(&timestamp));
@@ -121,10 +147,11 @@ void JSON_Export()
 
   if (has_aircraft) {
     root.printTo(buffer);
+    /* one write per line, other threads print to the same console */
     Serial.println(buffer);
   }
 
-  jsonBuffer.clear();
+  json.clear();
 }
 
 void parsePING(JsonObject& root)
@@ -171,7 +198,7 @@ void parsePING(JsonObject& root)
           aircraft_array[i].altitudeMM != 0) {
 
         fo = EmptyFO;
-        memset(fo.raw, 0, sizeof(fo.raw));
+        fo_cold = EmptyFO_Cold;
 
 #if 0
         std::tm t = {};
@@ -217,37 +244,24 @@ void parsePING(JsonObject& root)
 
         Traffic_Update(&fo);
 
-        int j;
-
         /* Try to find and update an entry with the same aircraft ID */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (Container[j].addr == fo.addr && Container[j].protocol == fo.protocol) {
-            Container[j] = fo;
-            break;
-          }
-        }
+        ufo_t *fop = Traffic_Lookup(fo.addr, fo.addr_type);
 
-        if (j < MAX_TRACKING_OBJECTS) {
-            continue;
+        if (fop) {
+          Traffic_Merge(fop, &fo);
+          continue;
         }
 
         /* Fill a free entry if able */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (Container[j].addr == 0 &&
-             memcmp(Container[j].raw, EmptyFO.raw, sizeof(EmptyFO.raw)) == 0) {
-            Container[j] = fo;
-            break;
-          }
-        }
-
-        if (j < MAX_TRACKING_OBJECTS) {
-            continue;
+        if (Traffic_Insert(&fo)) {
+          continue;
         }
 
         /* Overwrite expired entry */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (timestamp - Container[j].timestamp > ENTRY_EXPIRATION_TIME) {
-            Container[j] = fo;
+        for (int j=0; j < Traffic_Count(); j++) {
+          fop = Traffic_Entry(j);
+          if (timestamp - fop->timestamp > ENTRY_EXPIRATION_TIME) {
+            Traffic_Replace(fop, &fo);
             break;
           }
         }
@@ -255,20 +269,22 @@ void parsePING(JsonObject& root)
     }
 
 #if 0
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-      if (Container[i].addr &&
-          Container[i].latitude  != 0.0 &&
-          Container[i].longitude != 0.0 &&
-          Container[i].altitude  != 0.0) {
+    for (int i=0; i < Traffic_Count(); i++) {
+      ufo_t *fop = Traffic_Entry(i);
+
+      if (fop->addr &&
+          fop->latitude  != 0.0 &&
+          fop->longitude != 0.0 &&
+          fop->altitude  != 0.0) {
 
         printf("%06X %f %f %f %d %d %d\n",
-            Container[i].addr,
-            Container[i].latitude,
-            Container[i].longitude,
-            Container[i].altitude,
-            Container[i].addr_type,
-            (int) Container[i].vs,
-            Container[i].aircraft_type);
+            fop->addr,
+            fop->latitude,
+            fop->longitude,
+            fop->altitude,
+            fop->addr_type,
+            (int) fop->vs,
+            fop->aircraft_type);
       }
     }
 #endif
@@ -381,7 +397,7 @@ void parseD1090(JsonObject& root)
           aircraft_array[i].altitude != 0.0) {
 
         fo = EmptyFO;
-        memset(fo.raw, 0, sizeof(fo.raw));
+        fo_cold = EmptyFO_Cold;
 #if 0
         fo.timestamp = (time_t) (var_now - aircraft_array[i].seen_pos);
 #else
@@ -414,37 +430,24 @@ void parseD1090(JsonObject& root)
 
         Traffic_Update(&fo);
 
-        int j;
-
         /* Try to find and update an entry with the same aircraft ID */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (Container[j].addr == fo.addr && Container[j].protocol == fo.protocol) {
-            Container[j] = fo;
-            break;
-          }
-        }
+        ufo_t *fop = Traffic_Lookup(fo.addr, fo.addr_type);
 
-        if (j < MAX_TRACKING_OBJECTS) {
-            continue;
+        if (fop) {
+          Traffic_Merge(fop, &fo);
+          continue;
         }
 
         /* Fill a free entry if able */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (Container[j].addr == 0 &&
-             memcmp(Container[j].raw, EmptyFO.raw, sizeof(EmptyFO.raw)) == 0) {
-            Container[j] = fo;
-            break;
-          }
-        }
-
-        if (j < MAX_TRACKING_OBJECTS) {
-            continue;
+        if (Traffic_Insert(&fo)) {
+          continue;
         }
 
         /* Overwrite expired entry */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (timestamp - Container[j].timestamp > ENTRY_EXPIRATION_TIME) {
-            Container[j] = fo;
+        for (int j=0; j < Traffic_Count(); j++) {
+          fop = Traffic_Entry(j);
+          if (timestamp - fop->timestamp > ENTRY_EXPIRATION_TIME) {
+            Traffic_Replace(fop, &fo);
             break;
           }
         }
@@ -452,20 +455,22 @@ void parseD1090(JsonObject& root)
     }
 
 #if 0
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-      if (Container[i].addr &&
-          Container[i].latitude  != 0.0 &&
-          Container[i].longitude != 0.0 &&
-          Container[i].altitude  != 0.0) {
+    for (int i=0; i < Traffic_Count(); i++) {
+      ufo_t *fop = Traffic_Entry(i);
+
+      if (fop->addr &&
+          fop->latitude  != 0.0 &&
+          fop->longitude != 0.0 &&
+          fop->altitude  != 0.0) {
 
         printf("%06X %f %f %f %d %d %d\n",
-            Container[i].addr,
-            Container[i].latitude,
-            Container[i].longitude,
-            Container[i].altitude,
-            Container[i].addr_type,
-            (int) Container[i].vs,
-            Container[i].aircraft_type);
+            fop->addr,
+            fop->latitude,
+            fop->longitude,
+            fop->altitude,
+            fop->addr_type,
+            (int) fop->vs,
+            fop->aircraft_type);
       }
     }
 #endif
@@ -490,42 +495,34 @@ void parseRAW(JsonObject& root)
       if (data_len > 0) {
 
         fo = EmptyFO;
+        fo_cold = EmptyFO_Cold;
 
         if (data_len > 2 * MAX_PKT_SIZE) {
           data_len = 2 * MAX_PKT_SIZE;
         }
 
-        if (data_len > 2 * sizeof(fo.raw)) {
-          data_len = 2 * sizeof(fo.raw);
+        if (data_len > 2 * sizeof(fo_cold.raw)) {
+          data_len = 2 * sizeof(fo_cold.raw);
         }
 
         for(int j = 0; j < data_len ; j+=2)
         {
-          fo.raw[j>>1] = getVal(data[j+1]) + (getVal(data[j]) << 4);
+          fo_cold.raw[j>>1] = getVal(data[j+1]) + (getVal(data[j]) << 4);
         }
 
         fo.timestamp = timestamp;
         fo.protocol = RF_PROTOCOL_ADSB_1090;
 
-        int j;
-
         /* Fill a free entry if able */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (Container[j].addr == 0 &&
-             memcmp(Container[j].raw, EmptyFO.raw, sizeof(EmptyFO.raw)) == 0) {
-            Container[j] = fo;
-            break;
-          }
-        }
-
-        if (j < MAX_TRACKING_OBJECTS) {
-            continue;
+        if (Traffic_Insert(&fo)) {
+          continue;
         }
 
         /* Overwrite expired entry */
-        for (j=0; j < MAX_TRACKING_OBJECTS; j++) {
-          if (timestamp - Container[j].timestamp > ENTRY_EXPIRATION_TIME) {
-            Container[j] = fo;
+        for (int j=0; j < Traffic_Count(); j++) {
+          ufo_t *fop = Traffic_Entry(j);
+          if (timestamp - fop->timestamp > ENTRY_EXPIRATION_TIME) {
+            Traffic_Replace(fop, &fo);
             break;
           }
         }
@@ -533,11 +530,15 @@ void parseRAW(JsonObject& root)
     }
 
 #if 0
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-      if (memcmp(Container[i].raw, EmptyFO.raw, sizeof(EmptyFO.raw)) != 0) {
+    for (int i=0; i < Traffic_Count(); i++) {
+      ufo_t *fop = Traffic_Entry(i);
+
+      ufo_cold_t *cold = Traffic_Cold(fop);
+
+      if (memcmp(cold->raw, EmptyFO_Cold.raw, sizeof(EmptyFO_Cold.raw)) != 0) {
         size_t size = RF_Payload_Size(settings->rf_protocol);
-        size = size > sizeof(Container[i].raw) ? sizeof(Container[i].raw) : size;
-        String str = Bin2Hex(Container[i].raw, size);
+        size = size > sizeof(cold->raw) ? sizeof(cold->raw) : size;
+        String str = Bin2Hex(cold->raw, size);
         printf("%s\n", str.c_str());
       }
     }
@@ -684,6 +685,24 @@ void parseSettings(JsonObject& root)
     }
   }
 
+  JsonVariant protocol2 = root["protocol2"];
+  if (protocol2.success()) {
+    const char * protocol_s = protocol2.as<char*>();
+    if (!strcmp(protocol_s,"NONE")) {
+      eeprom_block.field.settings.rf_protocol2 = RF_PROTOCOL_NONE;
+    } else if (!strcmp(protocol_s,"LEGACY")) {
+      eeprom_block.field.settings.rf_protocol2 = RF_PROTOCOL_LEGACY;
+    } else if (!strcmp(protocol_s,"OGNTP")) {
+      eeprom_block.field.settings.rf_protocol2 = RF_PROTOCOL_OGNTP;
+    } else if (!strcmp(protocol_s,"P3I")) {
+      eeprom_block.field.settings.rf_protocol2 = RF_PROTOCOL_P3I;
+    } else if (!strcmp(protocol_s,"FANET")) {
+      eeprom_block.field.settings.rf_protocol2 = RF_PROTOCOL_FANET;
+    } else if (!strcmp(protocol_s,"UAT")) {
+      eeprom_block.field.settings.rf_protocol2 = RF_PROTOCOL_ADSB_UAT;
+    }
+  }
+
   JsonVariant band = root["band"];
   if (band.success()) {
     const char * band_s = band.as<char*>();
@@ -58,28 +58,30 @@ void MAVLinkShareTraffic()
 {
     time_t this_moment = now();
 
-    for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-      if (Container[i].addr && (this_moment - Container[i].timestamp) <= EXPORT_EXPIRATION_TIME) {
+    for (int i=0; i < Traffic_Count(); i++) {
+      ufo_t *fop = Traffic_Entry(i);
+
+      if (fop->addr && (this_moment - fop->timestamp) <= EXPORT_EXPIRATION_TIME) {
 
         char hexbuf[8];
         char callsign[8+1];
 
-        snprintf(hexbuf, sizeof(hexbuf), "%06X", Container[i].addr);
-        memcpy(callsign, GDL90_CallSign_Prefix[Container[i].protocol],
-          strlen(GDL90_CallSign_Prefix[Container[i].protocol]));
-        memcpy(callsign + strlen(GDL90_CallSign_Prefix[Container[i].protocol]),
+        snprintf(hexbuf, sizeof(hexbuf), "%06X", fop->addr);
+        memcpy(callsign, GDL90_CallSign_Prefix[fop->protocol],
+          strlen(GDL90_CallSign_Prefix[fop->protocol]));
+        memcpy(callsign + strlen(GDL90_CallSign_Prefix[fop->protocol]),
           hexbuf, strlen(hexbuf) + 1);
 
-        write_mavlink(  Container[i].addr,
-                        Container[i].latitude,
-                        Container[i].longitude,
-                        Container[i].altitude,
-                        Container[i].course,
-                        Container[i].speed * _GPS_MPS_PER_KNOT, /* m/s */
-                        Container[i].vs / (_GPS_FEET_PER_METER * 60.0), /* m/s */
+        write_mavlink(  fop->addr,
+                        fop->latitude,
+                        fop->longitude,
+                        fop->altitude,
+                        fop->course,
+                        fop->speed * _GPS_MPS_PER_KNOT, /* m/s */
+                        fop->vs / (_GPS_FEET_PER_METER * 60.0), /* m/s */
                         (settings->band == RF_BAND_US ? 1200 : 7000),
                         callsign,
-                        AT_TO_GDL90(Container[i].aircraft_type));
+                        AT_TO_GDL90(fop->aircraft_type));
 
       }
     }
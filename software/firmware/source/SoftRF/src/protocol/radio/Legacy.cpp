@@ -99,6 +99,57 @@ void btea(uint32_t *v, int8_t n, const uint32_t key[4]) {
     }
 }
 
+/*
+ * Same as btea() for the 5 words of Legacy payload, with the inner
+ * loop unrolled so that the words stay in registers. Payload is copied
+ * in and out as the packet is also accessed through its bit fields.
+ */
+#define MX5(p) (((z >> 5 ^ y << 2) + (y >> 3 ^ z << 4)) ^ ((sum ^ y) + (key[(p) ^ e] ^ z)))
+
+static void btea5_encode(void *data, const uint32_t key[4]) {
+    uint32_t v[5];
+    memcpy(v, data, sizeof(v));
+
+    uint32_t v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3], v4 = v[4];
+    uint32_t y, z = v4, sum = 0, e;
+    uint8_t rounds = ROUNDS;
+
+    do {
+        sum += DELTA;
+        e = (sum >> 2) & 3;
+        y = v1; z = v0 += MX5(0);
+        y = v2; z = v1 += MX5(1);
+        y = v3; z = v2 += MX5(2);
+        y = v4; z = v3 += MX5(3);
+        y = v0; z = v4 += MX5(0);
+    } while (--rounds);
+
+    v[0] = v0; v[1] = v1; v[2] = v2; v[3] = v3; v[4] = v4;
+    memcpy(data, v, sizeof(v));
+}
+
+static void btea5_decode(void *data, const uint32_t key[4]) {
+    uint32_t v[5];
+    memcpy(v, data, sizeof(v));
+
+    uint32_t v0 = v[0], v1 = v[1], v2 = v[2], v3 = v[3], v4 = v[4];
+    uint32_t y = v0, z, sum = ROUNDS * DELTA, e;
+    uint8_t rounds = ROUNDS;
+
+    do {
+        e = (sum >> 2) & 3;
+        z = v3; y = v4 -= MX5(0);
+        z = v2; y = v3 -= MX5(3);
+        z = v1; y = v2 -= MX5(2);
+        z = v0; y = v1 -= MX5(1);
+        z = v4; y = v0 -= MX5(0);
+        sum -= DELTA;
+    } while (--rounds);
+
+    v[0] = v0; v[1] = v1; v[2] = v2; v[3] = v3; v[4] = v4;
+    memcpy(data, v, sizeof(v));
+}
+
 /* http://pastebin.com/YK2f8bfm */
 long obscure(uint32_t key, uint32_t seed) {
     uint32_t m1 = seed * (key ^ (key >> 16));
@@ -116,6 +167,93 @@ void make_key(uint32_t key[4], uint32_t timestamp, uint32_t address) {
     }
 }
 
+/*
+ * The key changes every 64 seconds only, so keep it per aircraft
+ * rather than run make_key() on every packet.
+ */
+typedef struct {
+    bool     valid;
+    uint32_t bucket;
+    uint32_t address;
+    uint32_t key[4];
+} legacy_key_t;
+
+static legacy_key_t legacy_keys[LEGACY_KEY_CACHE_SIZE];
+
+static const uint32_t *legacy_key(uint32_t timestamp, uint32_t address) {
+    uint32_t bucket = timestamp >> 6;
+    legacy_key_t *k = &legacy_keys[(address ^ (address >> 8) ^ (address >> 16)) &
+                                   (LEGACY_KEY_CACHE_SIZE - 1)];
+
+    if (!k->valid || k->bucket != bucket || k->address != address) {
+        make_key(k->key, timestamp, address);
+        k->bucket  = bucket;
+        k->address = address;
+        k->valid   = true;
+    }
+
+    return k->key;
+}
+
+uint32_t legacy_skew_recovered = 0;
+
+/* even parity of the whole packet, folded down to one byte */
+static bool legacy_parity_ok(const legacy_packet_t *pkt) {
+    uint32_t w[6];
+
+    memcpy(w, pkt, sizeof(w));
+
+    uint32_t x = w[0] ^ w[1] ^ w[2] ^ w[3] ^ w[4] ^ w[5];
+
+    x ^= x >> 16;
+    x ^= x >> 8;
+
+    return (parity(x & 0xFF) == 0);
+}
+
+static bool legacy_is_near(const legacy_packet_t *pkt, float ref_lat, float ref_lon) {
+    int32_t round_lat = (int32_t) (ref_lat * 1e7) >> 7;
+    int32_t lat = (pkt->lat - round_lat) % (uint32_t) 0x080000;
+    if (lat >= 0x040000) lat -= 0x080000;
+
+    int32_t round_lon = (int32_t) (ref_lon * 1e7) >> 7;
+    int32_t lon = (pkt->lon - round_lon) % (uint32_t) 0x100000;
+    if (lon >= 0x080000) lon -= 0x100000;
+
+    return (abs(lat) < LEGACY_SKEW_MAX_OFFSET && abs(lon) < LEGACY_SKEW_MAX_OFFSET);
+}
+
+/*
+ * Own or sender's clock may be a second off around the 64 s key
+ * boundary. Retry with the key of t-1 or t+1 when that falls into
+ * another bucket; the result must pass parity and be near us.
+ */
+static bool legacy_decode_skewed(legacy_packet_t *pkt, const uint32_t cipher[5],
+                                 uint32_t timestamp, uint32_t address,
+                                 float ref_lat, float ref_lon) {
+    static const int8_t skew[] = { -1, 1 };
+    uint32_t key[4];
+
+    for (uint8_t i = 0; i < sizeof(skew); i++) {
+        uint32_t t = timestamp + skew[i];
+
+        if ((t >> 6) == (timestamp >> 6)) {
+            continue; /* same key as already tried */
+        }
+
+        make_key(key, t, address);
+        memcpy((uint32_t *) pkt + 1, cipher, 5 * sizeof(uint32_t));
+        btea5_decode((uint32_t *) pkt + 1, key);
+
+        if (legacy_parity_ok(pkt) && legacy_is_near(pkt, ref_lat, ref_lon)) {
+            legacy_skew_recovered++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool legacy_decode(void *legacy_pkt, ufo_t *this_aircraft, ufo_t *fop) {
 
     legacy_packet_t *pkt = (legacy_packet_t *) legacy_pkt;
@@ -125,22 +263,31 @@ bool legacy_decode(void *legacy_pkt, ufo_t *this_aircraft, ufo_t *fop) {
     float geo_separ = this_aircraft->geoid_separation;
     uint32_t timestamp = (uint32_t) this_aircraft->timestamp;
 
-    uint32_t key[4];
-    int ndx;
-    uint8_t pkt_parity=0;
+    uint32_t address = (pkt->addr << 8) & 0xffffff;
+    uint32_t cipher[5], plain[5];
 
-    make_key(key, timestamp, (pkt->addr << 8) & 0xffffff);
-    btea((uint32_t *) pkt + 1, -5, key);
+    memcpy(cipher, (uint32_t *) pkt + 1, sizeof(cipher));
+    btea5_decode((uint32_t *) pkt + 1, legacy_key(timestamp, address));
 
-    for (ndx = 0; ndx < sizeof (legacy_packet_t); ndx++) {
-      pkt_parity += parity(*(((unsigned char *) pkt) + ndx));
-    }
-    if (pkt_parity % 2) {
-        if (settings->nmea_p) {
-          StdOut.print(F("$PSRFE,bad parity of decoded packet: "));
-          StdOut.println(pkt_parity % 2, HEX);
+    /*
+     * One parity bit passes every other wrong key, so a far away
+     * result is worth a retry too. Keep it when no neighbour does better.
+     */
+    bool parity_ok = legacy_parity_ok(pkt);
+
+    if (!parity_ok || !legacy_is_near(pkt, ref_lat, ref_lon)) {
+        memcpy(plain, (uint32_t *) pkt + 1, sizeof(plain));
+
+        if (!legacy_decode_skewed(pkt, cipher, timestamp, address, ref_lat, ref_lon)) {
+            if (!parity_ok) {
+                if (settings->nmea_p) {
+                  StdOut.print(F("$PSRFE,bad parity of decoded packet: "));
+                  StdOut.println(1, HEX);
+                }
+                return false;
+            }
+            memcpy((uint32_t *) pkt + 1, plain, sizeof(plain));
         }
-        return false;
     }
 
     int32_t round_lat = (int32_t) (ref_lat * 1e7) >> 7;
@@ -186,10 +333,10 @@ bool legacy_decode(void *legacy_pkt, ufo_t *this_aircraft, ufo_t *fop) {
     fop->no_track = pkt->no_track;
     fop->flying = pkt->airborne;
     fop->turning = pkt->turning;
-//    fop->ns[0] = pkt->ns[0]; fop->ns[1] = pkt->ns[1];  // not needed
-//    fop->ns[2] = pkt->ns[2]; fop->ns[3] = pkt->ns[3];
-//    fop->ew[0] = pkt->ew[0]; fop->ew[1] = pkt->ew[1];
-//    fop->ew[2] = pkt->ew[2]; fop->ew[3] = pkt->ew[3];
+    fop->ns[0] = pkt->ns[0]; fop->ns[1] = pkt->ns[1];  // used by CPA alarm
+    fop->ns[2] = pkt->ns[2]; fop->ns[3] = pkt->ns[3];
+    fop->ew[0] = pkt->ew[0]; fop->ew[1] = pkt->ew[1];
+    fop->ew[2] = pkt->ew[2]; fop->ew[3] = pkt->ew[3];
     float turnRate = atan2f(pkt->ew[2],pkt->ns[2]) - atan2f(pkt->ew[1],pkt->ns[1]);
     if (turnRate > PI) {
 	    turnRate -= 2* PI;
@@ -224,7 +371,7 @@ size_t legacy_encode(void *legacy_pkt, ufo_t *this_aircraft) {
 
     int ndx;
     uint8_t pkt_parity=0;
-    uint32_t key[4];
+    const uint32_t *key;
 
     uint32_t id = this_aircraft->addr;
     float lat = this_aircraft->latitude;
@@ -397,7 +544,7 @@ size_t legacy_encode(void *legacy_pkt, ufo_t *this_aircraft) {
 
     pkt->parity = (pkt_parity % 2);
 
-    make_key(key, timestamp , (pkt->addr << 8) & 0xffffff);
+    key = legacy_key(timestamp, (pkt->addr << 8) & 0xffffff);
 
 #if 0
     Serial.print(key[0]);   Serial.print(", ");
@@ -405,7 +552,7 @@ size_t legacy_encode(void *legacy_pkt, ufo_t *this_aircraft) {
     Serial.print(key[2]);   Serial.print(", ");
     Serial.println(key[3]);
 #endif
-    btea((uint32_t *) pkt + 1, 5, key);
+    btea5_encode((uint32_t *) pkt + 1, key);
 
     return (sizeof(legacy_packet_t));
 }
@@ -37,6 +37,18 @@
 #define LEGACY_KEY2 0x045d9f3b
 #define LEGACY_KEY3 0x87b562f4
 
+/* XXTEA keys of recently heard aircraft, power of 2 */
+#if !defined(LEGACY_KEY_CACHE_SIZE)
+#define LEGACY_KEY_CACHE_SIZE  16
+#endif
+
+/*
+ * Packets that decrypt only with a neighbouring second's key have to
+ * be this close to own position, in lat/lon units of the packet
+ * (2^7 * 1e-7 deg), about 20 km.
+ */
+#define LEGACY_SKEW_MAX_OFFSET 0x4000
+
 /* FTD-12 Version: 7.00 */
 enum
 {
@@ -135,9 +147,14 @@ typedef struct {
     /********************/
 } __attribute__((packed)) legacy_packet_t;
 
+/* ns[]/ew[] extrapolation steps in seconds, [0] - glider, [1] - other types */
+extern const int32_t EP[2][4];
+
 bool legacy_decode(void *, ufo_t *, ufo_t *);
 size_t legacy_encode(void *, ufo_t *);
 
+extern uint32_t legacy_skew_recovered;
+
 extern const rf_proto_desc_t legacy_proto_desc;
 
 #endif /* PROTOCOL_LEGACY_H */
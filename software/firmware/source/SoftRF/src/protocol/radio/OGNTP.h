@@ -30,6 +30,9 @@
 #define OGNTP_CRC_TYPE        RF_CHECKSUM_TYPE_GALLAGER
 #define OGNTP_CRC_SIZE        6
 
+/* iteration budget of the soft decision LDPC decoder */
+#define OGNTP_LDPC_ITERATIONS 32
+
 #define OGNTP_TX_INTERVAL_MIN 600 /* in ms */
 #define OGNTP_TX_INTERVAL_MAX 1400
 
@@ -46,4 +49,4 @@ extern const rf_proto_desc_t ogntp_proto_desc;
 bool ogntp_decode(void *, ufo_t *, ufo_t *);
 size_t ogntp_encode(void *, ufo_t *);
 
-#endif /* PROTOCOL_OGNTP_H */
\ No newline at end of file
+#endif /* PROTOCOL_OGNTP_H */
\ No newline at end of file
@@ -21,10 +21,12 @@
 #include <stdint.h>
 
 #include <protocol.h>
+#include <crc_fast.h>
 
 #include "../../../SoftRF.h"
 #include "../../driver/RF.h"
 #include "../data/GDL90.h"
+#include "../../TrafficHelper.h"
 
 const rf_proto_desc_t uat978_proto_desc = {
   "UAT",
@@ -85,8 +87,9 @@ bool uat978_decode(void *pkt, ufo_t *this_aircraft, ufo_t *fop) {
   fop->ew[0] = 0; fop->ew[1] = 0;
   fop->ew[2] = 0; fop->ew[3] = 0;
 
-  /* sizeof(mdb.callsign) = 9 ; sizeof(fop->callsign) = 8 */
-  memcpy(fop->callsign, mdb.callsign, sizeof(fop->callsign));
+  /* sizeof(mdb.callsign) = 9 ; sizeof(ufo_cold_t.callsign) = 8 */
+  ufo_cold_t *cold = Traffic_Cold(fop);
+  memcpy(cold->callsign, mdb.callsign, sizeof(cold->callsign));
 
   return true;
 }
@@ -97,3 +100,130 @@ size_t uat978_encode(void *pkt, ufo_t *this_aircraft) {
 
   return (0);
 }
+
+/*
+ * Byte quality hints for correct_adsb_frame_erasures().
+ * Radio front ends at hand report RSSI per packet only, so what is known
+ * per byte is whether it has been received at all.
+ */
+int uat978_erasures(size_t len, int *erasures)
+{
+  int count = 0;
+
+  for (size_t i = len; i < LONG_FRAME_BYTES; i++) {
+    erasures[count++] = i;
+  }
+
+  return count;
+}
+
+/* Puts one frame of the UAT_Receiver link into buf, returns its size */
+size_t uatm_encode(uint8_t *buf, uint8_t type, const uint8_t *data,
+                   size_t length, int8_t rssi, uint32_t timestamp)
+{
+  uint16_t crc;
+
+  buf[0] = UATM_SYNC_1;
+  buf[1] = UATM_SYNC_2;
+  buf[2] = type;
+  buf[3] = length;
+  buf[4] = (uint8_t) rssi;
+  buf[5] =  timestamp        & 0xFF;
+  buf[6] = (timestamp >>  8) & 0xFF;
+  buf[7] = (timestamp >> 16) & 0xFF;
+  buf[8] = (timestamp >> 24) & 0xFF;
+  memcpy(buf + UATM_HEADER_SIZE, data, length);
+
+  crc = crc16_ccitt(CRC16_CCITT_FFFF_SEED, buf + 2,
+                    UATM_HEADER_SIZE - 2 + length);
+  buf[UATM_HEADER_SIZE + length]     = (crc >> 8) & 0xFF;
+  buf[UATM_HEADER_SIZE + length + 1] =  crc       & 0xFF;
+
+  return UATM_FRAME_SIZE(length);
+}
+
+static bool uatm_length_valid(uint8_t type, uint8_t length)
+{
+  switch (type)
+  {
+  case UATM_TYPE_ADSB_SHORT:  return length == SHORT_FRAME_DATA_BYTES;
+  case UATM_TYPE_ADSB_LONG:   return length == LONG_FRAME_DATA_BYTES;
+  case UATM_TYPE_RAW:         return length > 0 && length <= LONG_FRAME_BYTES;
+  default:                    return false;
+  }
+}
+
+/*
+ * Looks for the next frame in buf[*pos, len), skipping over whatever does
+ * not check out. Stratux UATradio frames are taken too, as UATM_TYPE_RAW.
+ * Returns false with *pos at the first byte to keep for the next call
+ * when the rest of the buffer holds no complete frame.
+ */
+bool uatm_decode(const uint8_t *buf, size_t len, size_t *pos,
+                 uatm_frame_t *frame)
+{
+  size_t i = *pos;
+
+  while (i < len) {
+    const uint8_t *p = buf + i;
+    size_t avail = len - i;
+
+    if (p[0] == UATM_SYNC_1) {
+      if (avail < UATM_HEADER_SIZE) {
+        break;
+      }
+      if (p[1] == UATM_SYNC_2 && uatm_length_valid(p[2], p[3])) {
+        size_t size = UATM_FRAME_SIZE(p[3]);
+        uint16_t crc;
+
+        if (avail < size) {
+          break;
+        }
+
+        crc = crc16_ccitt(CRC16_CCITT_FFFF_SEED, p + 2,
+                          UATM_HEADER_SIZE - 2 + p[3]);
+        if (p[size - 2] == ((crc >> 8) & 0xFF) &&
+            p[size - 1] == ( crc       & 0xFF)) {
+          frame->type      = p[2];
+          frame->length    = p[3];
+          frame->rssi      = (int8_t) p[4];
+          frame->timestamp = (uint32_t) p[5]         | (uint32_t) p[6] <<  8 |
+                             (uint32_t) p[7] << 16   | (uint32_t) p[8] << 24;
+          frame->data      = p + UATM_HEADER_SIZE;
+
+          *pos = i + size;
+          return true;
+        }
+      }
+    } else if (p[0] == STRATUX_UATRADIO_MAGIC_1) {
+      if (avail < 4) {
+        break;
+      }
+      if (p[1] == STRATUX_UATRADIO_MAGIC_2 &&
+          p[2] == STRATUX_UATRADIO_MAGIC_3 &&
+          p[3] == STRATUX_UATRADIO_MAGIC_4) {
+        const Stratux_frame_t *f = (const Stratux_frame_t *) p;
+
+        if (avail < sizeof(Stratux_frame_t)) {
+          break;
+        }
+
+        frame->type      = UATM_TYPE_RAW;
+        frame->length    = f->msgLen < LONG_FRAME_BYTES ?
+                           f->msgLen : LONG_FRAME_BYTES;
+        frame->rssi      = f->rssi;
+        frame->timestamp = f->timestamp;
+        frame->data      = f->data;
+
+        *pos = i + sizeof(Stratux_frame_t);
+        return true;
+      }
+    }
+
+    /* nothing here, resync on the next byte */
+    i++;
+  }
+
+  *pos = i;
+  return false;
+}
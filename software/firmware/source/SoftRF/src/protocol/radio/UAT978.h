@@ -55,6 +55,36 @@ typedef struct __attribute__ ((packed)) Stratux_LPUATRadio_UART_frame {
   uint8_t   data[LONG_FRAME_BYTES];
 } Stratux_frame_t;
 
+/*
+ * SoftRF UAT_Receiver to host link.
+ * Frames are FEC corrected by the receiver and carry data bytes only:
+ *
+ *   sync (2), type (1), length (1), rssi (1), timestamp (4, LE),
+ *   data (length), CRC-16 CCITT of type..data (2, MSB first)
+ *
+ * Several of them go out in one UART write of up to UATM_BATCH_SIZE.
+ */
+#define UATM_SYNC_1             0xD3
+#define UATM_SYNC_2             0x91
+#define UATM_HEADER_SIZE        9
+#define UATM_CRC_SIZE           2
+#define UATM_FRAME_SIZE(len)    (UATM_HEADER_SIZE + (len) + UATM_CRC_SIZE)
+
+#define UATM_TYPE_RAW           0   /* not corrected, LONG_FRAME_BYTES at most */
+#define UATM_TYPE_ADSB_SHORT    1   /* as correct_adsb_frame() returns */
+#define UATM_TYPE_ADSB_LONG     2
+
+#define UATM_BATCH_SIZE         256 /* bytes, one UART DMA transfer */
+#define UATM_BATCH_TIMEOUT      10  /* ms a frame may wait for others */
+
+typedef struct {
+  uint8_t         type;
+  uint8_t         length;
+  int8_t          rssi;
+  uint32_t        timestamp;  /* millis() of the receiver */
+  const uint8_t  *data;
+} uatm_frame_t;
+
 typedef struct {
 
   /* Dummy type definition. Actual Rx packet format is defined in uat_decode.h */
@@ -65,5 +95,8 @@ extern const rf_proto_desc_t uat978_proto_desc;
 
 bool   uat978_decode(void *, ufo_t *, ufo_t *);
 size_t uat978_encode(void *, ufo_t *);
+int    uat978_erasures(size_t, int *);
+size_t uatm_encode(uint8_t *, uint8_t, const uint8_t *, size_t, int8_t, uint32_t);
+bool   uatm_decode(const uint8_t *, size_t, size_t *, uatm_frame_t *);
 
-#endif /* PROTOCOL_UAT978_H */
\ No newline at end of file
+#endif /* PROTOCOL_UAT978_H */
\ No newline at end of file
@@ -17,6 +17,149 @@
  */
 
 #include "SoC.h"
+#include "Time.h"
+#include "../driver/GNSS.h"
+
+typedef struct {
+  int32_t  second;  /* UTC second count of the edge, relative to the first one */
+  uint64_t us;      /* Time_micros64() at the edge */
+} pps_sample_t;
+
+static uint32_t Time_us_prev  = 0;
+static uint64_t Time_us_upper = 0;
+
+static pps_sample_t Time_PPS_ring[TIME_PPS_SAMPLES];
+static uint8_t  Time_PPS_count   = 0;
+static uint8_t  Time_PPS_head    = 0;
+static uint8_t  Time_PPS_rejects = 0;
+static uint32_t Time_PPS_marker  = 0;
+
+/* fitted position of the newest edge (ref + phase) and period, in 1/256 us */
+static uint64_t Time_PPS_ref     = 0;
+static int64_t  Time_PPS_phase   = 0;
+static int64_t  Time_PPS_period  = 1000000LL << 8;
+
+/*
+ * micros() extended to 64 bits. Wraps every 71 minutes on its own,
+ * so it has to be called at least that often - RF_loop() does.
+ * Not for use from an ISR.
+ */
+uint64_t Time_micros64()
+{
+  uint32_t us = (uint32_t) micros();
+
+  if (us < Time_us_prev) {
+    Time_us_upper += 0x100000000ULL;
+  }
+  Time_us_prev = us;
+
+  return Time_us_upper | us;
+}
+
+/* least squares fit of edge time vs. UTC second over the window */
+static void Time_PPS_fit()
+{
+  const pps_sample_t *last = &Time_PPS_ring[Time_PPS_head];
+  int64_t n = Time_PPS_count;
+  int64_t sx = 0, sy = 0, sxx = 0, sxy = 0;
+
+  for (uint8_t i = 0; i < Time_PPS_count; i++) {
+    const pps_sample_t *s =
+      &Time_PPS_ring[(Time_PPS_head + TIME_PPS_SAMPLES - i) % TIME_PPS_SAMPLES];
+    int64_t x = s->second - last->second;
+    int64_t y = (int64_t) (s->us - last->us);
+
+    sx  += x;
+    sy  += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+
+  Time_PPS_ref = last->us;
+
+  int64_t d = n * sxx - sx * sx;
+  if (d == 0) {
+    Time_PPS_phase = 0;
+    return;
+  }
+
+  Time_PPS_period = ((n * sxy - sx * sy) * 256) / d;
+  Time_PPS_phase  = (sy * 256 - Time_PPS_period * sx) / n;
+}
+
+static void Time_PPS_sample(uint64_t us)
+{
+  if (Time_PPS_count > 0) {
+    const pps_sample_t *last = &Time_PPS_ring[Time_PPS_head];
+    int64_t dt  = (int64_t) (us - last->us) << 8;
+    int64_t n   = (dt + Time_PPS_period / 2) / Time_PPS_period;
+    int64_t err = dt - n * Time_PPS_period;
+
+    if (n < 1 || n > TIME_PPS_HOLDOVER) {
+      /* PPS came back after a long gap or the timebase jumped */
+      Time_PPS_count = 0;
+    } else if (err < 0 ? -err > ((int64_t) TIME_PPS_TOLERANCE_US << 8) * n :
+                          err > ((int64_t) TIME_PPS_TOLERANCE_US << 8) * n) {
+      /* a glitch, unless it keeps happening */
+      if (++Time_PPS_rejects < TIME_PPS_LOCK_SAMPLES) {
+        return;
+      }
+      Time_PPS_count = 0;
+    } else {
+      int32_t second = last->second + (int32_t) n;
+
+      Time_PPS_head = (Time_PPS_head + 1) % TIME_PPS_SAMPLES;
+      Time_PPS_ring[Time_PPS_head].second = second;
+      Time_PPS_ring[Time_PPS_head].us     = us;
+      if (Time_PPS_count < TIME_PPS_SAMPLES) {
+        Time_PPS_count++;
+      }
+    }
+  }
+
+  if (Time_PPS_count == 0) {
+    Time_PPS_ring[Time_PPS_head].second = 0;
+    Time_PPS_ring[Time_PPS_head].us     = us;
+    Time_PPS_count  = 1;
+    Time_PPS_period = 1000000LL << 8;
+  }
+
+  Time_PPS_rejects = 0;
+  Time_PPS_fit();
+}
+
+void Time_loop()
+{
+  uint32_t marker = (uint32_t) PPS_TimeMarker_us;
+
+  if (marker != Time_PPS_marker) {
+    uint64_t now = Time_micros64();
+
+    Time_PPS_marker = marker;
+    Time_PPS_sample(now - (uint32_t) ((uint32_t) now - marker));
+  }
+}
+
+/* enough consistent edges, and the last one within holdover */
+bool Time_PPS_locked()
+{
+  return Time_PPS_count >= TIME_PPS_LOCK_SAMPLES &&
+         Time_micros64() - Time_PPS_ring[Time_PPS_head].us <
+         TIME_PPS_HOLDOVER * 1000000ULL;
+}
+
+/* estimated Time_micros64() of the last UTC second edge at or before 'us' */
+uint64_t Time_PPS_edge(uint64_t us)
+{
+  int64_t d = ((int64_t) (us - Time_PPS_ref) << 8) - Time_PPS_phase;
+  int64_t m = d / Time_PPS_period;
+
+  if (d < 0 && m * Time_PPS_period != d) {
+    m--;
+  }
+
+  return Time_PPS_ref + (uint64_t) ((Time_PPS_phase + m * Time_PPS_period) >> 8);
+}
 
 #if defined(EXCLUDE_WIFI)
 void Time_setup()     {}
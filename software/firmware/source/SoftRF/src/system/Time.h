@@ -19,6 +19,19 @@
 #ifndef TIMEHELPER_H
 #define TIMEHELPER_H
 
-void Time_setup(void);
+/* PPS disciplined timebase */
+#if !defined(TIME_PPS_SAMPLES)
+#define TIME_PPS_SAMPLES        8     /* PPS edges in the regression window */
+#endif
+#define TIME_PPS_LOCK_SAMPLES   3     /* edges needed before the fit is used */
+#define TIME_PPS_TOLERANCE_US   2000  /* max. edge deviation per second elapsed */
+#define TIME_PPS_HOLDOVER       60    /* seconds to flywheel without PPS */
 
-#endif /* TIMEHELPER_H */
\ No newline at end of file
+void     Time_setup(void);
+void     Time_loop(void);
+
+uint64_t Time_micros64(void);
+bool     Time_PPS_locked(void);
+uint64_t Time_PPS_edge(uint64_t);
+
+#endif /* TIMEHELPER_H */
\ No newline at end of file
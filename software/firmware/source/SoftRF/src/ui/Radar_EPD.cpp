@@ -110,18 +110,20 @@ static void EPD_Draw_Radar()
     display->fillScreen(GxEPD_WHITE);
 
     {
-      for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-        if (Container[i].addr && (now() - Container[i].timestamp) <= EPD_EXPIRATION_TIME) {
+      for (int i=0; i < Traffic_Count(); i++) {
+        ufo_t *fop = Traffic_Entry(i);
+
+        if (fop->addr && (now() - fop->timestamp) <= EPD_EXPIRATION_TIME) {
 
           int16_t rel_x;
           int16_t rel_y;
           float distance;
           float bearing;
 
-          bool isTeam = (Container[i].addr == ui->team) ;
+          bool isTeam = (fop->addr == ui->team) ;
 
-          distance = Container[i].distance;
-          bearing  = Container[i].bearing;
+          distance = fop->distance;
+          bearing  = fop->bearing;
 
           switch (ui->orientation)
           {
@@ -143,7 +145,7 @@ static void EPD_Draw_Radar()
           int16_t x = ((int32_t) rel_x * (int32_t) radius) / divider;
           int16_t y = ((int32_t) rel_y * (int32_t) radius) / divider;
 
-          float RelativeVertical = Container[i].altitude - ThisAircraft.altitude;
+          float RelativeVertical = fop->altitude - ThisAircraft.altitude;
 
           if        (RelativeVertical >   EPD_RADAR_V_THRESHOLD) {
             if (isTeam) {
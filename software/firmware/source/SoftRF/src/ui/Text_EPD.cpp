@@ -75,11 +75,13 @@ static void EPD_Draw_Text()
   char info_line [TEXT_VIEW_LINE_LENGTH];
   char id_text   [TEXT_VIEW_LINE_LENGTH];
 
-  for (int i=0; i < MAX_TRACKING_OBJECTS; i++) {
-    if (Container[i].addr && (now() - Container[i].timestamp) <= EPD_EXPIRATION_TIME) {
+  for (int i=0; i < Traffic_Count(); i++) {
+    ufo_t *fop = Traffic_Entry(i);
 
-      traffic_by_dist[j].fop = &Container[i];
-      traffic_by_dist[j].distance = Container[i].distance;
+    if (fop->addr && (now() - fop->timestamp) <= EPD_EXPIRATION_TIME) {
+
+      traffic_by_dist[j].fop = fop;
+      traffic_by_dist[j].distance = fop->distance;
       j++;
     }
   }
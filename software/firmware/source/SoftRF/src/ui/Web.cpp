@@ -598,7 +598,7 @@ void handleRoot() {
   char str_alt[16];
   char str_Vcc[8];
 
-  size_t size = 2300;
+  size_t size = 2600;
   char *Root_temp = (char *) malloc(size);
   if (Root_temp == NULL) {
     return;
@@ -645,6 +645,9 @@ void handleRoot() {
     <td align=right><table><tr>\
      <th align=left>Tx&nbsp;&nbsp;</th><td align=right>%u</td>\
      <th align=left>&nbsp;&nbsp;&nbsp;&nbsp;Rx&nbsp;&nbsp;</th><td align=right>%u</td>\
+     <th align=left>&nbsp;&nbsp;&nbsp;&nbsp;Lost&nbsp;&nbsp;</th><td align=right>%u</td>\
+     <th align=left>&nbsp;&nbsp;&nbsp;&nbsp;FEC&nbsp;&nbsp;</th><td align=right>%u</td>\
+     <th align=left>&nbsp;&nbsp;&nbsp;&nbsp;Skew&nbsp;&nbsp;</th><td align=right>%u</td>\
    </tr></table></td></tr>\
  </table>\
  <h2 align=center>Most recent GNSS fix</h2>\
@@ -679,7 +682,8 @@ void handleRoot() {
 #endif /* ENABLE_AHRS */
     hr, min % 60, sec % 60, ESP.getFreeHeap(),
     low_voltage ? "red" : "green", str_Vcc,
-    tx_packets_counter, rx_packets_counter,
+    tx_packets_counter, rx_packets_counter, rx_packets_lost, rx_packets_corrected,
+    legacy_skew_recovered,
     timestamp, sats, str_lat, str_lon, str_alt
   );
   SoC->swSer_enableRx(false);
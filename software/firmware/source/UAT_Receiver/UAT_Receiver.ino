@@ -32,6 +32,11 @@
 #include "src/driver/Battery.h"
 
 #include "EasyLink.h"
+#include "src/protocol/radio/UAT978.h"
+
+#include <uat.h>
+#include <fec/char.h>
+#include <fec.h>
 
 //#define DEBUG_UAT
 
@@ -50,16 +55,20 @@ hardware_info_t hw_info = {
   .display  = DISPLAY_NONE
 };
 
-Stratux_frame_t LPUATRadio_frame = {
-  .magic1     = STRATUX_UATRADIO_MAGIC_1,
-  .magic2     = STRATUX_UATRADIO_MAGIC_2,
-  .magic3     = STRATUX_UATRADIO_MAGIC_3,
-  .magic4     = STRATUX_UATRADIO_MAGIC_4,
+int erasures[LONG_FRAME_BYTES];
 
-  .msgLen     = LONG_FRAME_BYTES,
-  .rssi       = 0,
-  .timestamp  = 0UL,
-};
+/* frames waiting to go out to the host in one write */
+static uint8_t UAT_batch[UATM_BATCH_SIZE];
+static size_t  UAT_batch_len  = 0;
+static unsigned long UAT_batch_time = 0;
+
+static void UAT_Batch_Flush()
+{
+  if (UAT_batch_len > 0) {
+    Serial.write(UAT_batch, UAT_batch_len);
+    UAT_batch_len = 0;
+  }
+}
 
 #if defined(DEBUG_UAT)
 #include <xdc/std.h>
@@ -244,6 +253,8 @@ void setup() {
 
   if (hw_info.display != DISPLAY_NONE)  delay(3000);
 
+  init_fec();
+
   myLink.begin(EasyLink_Phy_Custom);
   Serial.println("Listening...");
 
@@ -259,13 +270,35 @@ void loop() {
   bool success = UAT_Receive();
 
   if (success) {
-    LPUATRadio_frame.timestamp  = now();
-    LPUATRadio_frame.rssi       = rxPacket.rssi;
-    LPUATRadio_frame.msgLen     = rxPacket.len;
+    int rs_errors;
+    int n_erasures = uat978_erasures(rxPacket.len, erasures);
+    int frame_type = correct_adsb_frame_erasures(rxPacket.payload,
+                                                 erasures, n_erasures,
+                                                 &rs_errors);
+    size_t size = 0;
+
+    if (frame_type == 1) {
+      size = SHORT_FRAME_DATA_BYTES;
+    } else if (frame_type == 2) {
+      size = LONG_FRAME_DATA_BYTES;
+    }
 
-    memcpy(LPUATRadio_frame.data, rxPacket.payload, rxPacket.len);
+    if (size > 0) {
+      if (UAT_batch_len + UATM_FRAME_SIZE(size) > sizeof(UAT_batch)) {
+        UAT_Batch_Flush();
+      }
+      if (UAT_batch_len == 0) {
+        UAT_batch_time = millis();
+      }
+
+      UAT_batch_len += uatm_encode(UAT_batch + UAT_batch_len, frame_type,
+                                   rxPacket.payload, size, rxPacket.rssi,
+                                   millis());
+    }
+  }
 
-    Serial.write((uint8_t *) &LPUATRadio_frame, sizeof(LPUATRadio_frame));
+  if (UAT_batch_len > 0 && millis() - UAT_batch_time >= UATM_BATCH_TIMEOUT) {
+    UAT_Batch_Flush();
   }
 
   // Show status info on tiny OLED display
@@ -44,6 +44,7 @@
 #define isValidFix()      isValidGNSSFix()
 
 EasyLink_RxPacket rxPacket;
+int erasures[LONG_FRAME_BYTES];
 extern EasyLink myLink;
 extern FreqPlan RF_FreqPlan;
 
@@ -299,7 +300,10 @@ void loop() {
     int rs_errors;
     ThisAircraft.timestamp = now();
 
-    int frame_type = correct_adsb_frame(rxPacket.payload, &rs_errors);
+    int n_erasures = uat978_erasures(rxPacket.len, erasures);
+    int frame_type = correct_adsb_frame_erasures(rxPacket.payload,
+                                                 erasures, n_erasures,
+                                                 &rs_errors);
 
     if (frame_type != -1 &&
         uat978_decode((void *) rxPacket.payload, &ThisAircraft, &fo) ) {
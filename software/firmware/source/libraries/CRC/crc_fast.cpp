@@ -0,0 +1,128 @@
+/*
+ * crc_fast.cpp
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "crc_fast.h"
+
+/*
+ * Entry i of slice k is the register after byte i followed by k zero
+ * bytes, so that k+1 input bytes resolve with k+1 independent lookups.
+ */
+constexpr uint16_t crc16_ccitt_entry(int slice, int i)
+{
+  return slice == 0 ? crc16_ccitt_byte(0, i) :
+                      crc16_ccitt_byte(crc16_ccitt_entry(slice - 1, i), 0);
+}
+
+constexpr uint8_t crc8_107_entry(int slice, int i)
+{
+  return slice == 0 ? crc8_107_byte(0, i) :
+                      crc8_107_byte(crc8_107_entry(slice - 1, i), 0);
+}
+
+#define CRC_ROW4(f, k, i)   f(k, (i)), f(k, (i) + 1), f(k, (i) + 2), f(k, (i) + 3)
+#define CRC_ROW16(f, k, i)  CRC_ROW4(f, k, (i)),      CRC_ROW4(f, k, (i) + 4),  \
+                            CRC_ROW4(f, k, (i) + 8),  CRC_ROW4(f, k, (i) + 12)
+#define CRC_ROW64(f, k, i)  CRC_ROW16(f, k, (i)),     CRC_ROW16(f, k, (i) + 16), \
+                            CRC_ROW16(f, k, (i) + 32), CRC_ROW16(f, k, (i) + 48)
+#define CRC_ROW(f, k)       { CRC_ROW64(f, k, 0),   CRC_ROW64(f, k, 64),   \
+                              CRC_ROW64(f, k, 128), CRC_ROW64(f, k, 192) }
+
+#if CRC_SLICES == 8
+#define CRC_TABLE(f)        { CRC_ROW(f, 0), CRC_ROW(f, 1), CRC_ROW(f, 2), \
+                              CRC_ROW(f, 3), CRC_ROW(f, 4), CRC_ROW(f, 5), \
+                              CRC_ROW(f, 6), CRC_ROW(f, 7) }
+#elif CRC_SLICES == 4
+#define CRC_TABLE(f)        { CRC_ROW(f, 0), CRC_ROW(f, 1), CRC_ROW(f, 2), \
+                              CRC_ROW(f, 3) }
+#else
+#error "CRC_SLICES must be 4 or 8"
+#endif
+
+constexpr uint16_t crc16_ccitt_table[CRC_SLICES][256] PROGMEM =
+  CRC_TABLE(crc16_ccitt_entry);
+
+constexpr uint8_t  crc8_107_table[CRC_SLICES][256] PROGMEM =
+  CRC_TABLE(crc8_107_entry);
+
+#define T16(k, i)   pgm_read_word(&crc16_ccitt_table[k][i])
+#define T8(k, i)    pgm_read_byte(&crc8_107_table[k][i])
+
+uint16_t crc16_ccitt(uint16_t crc, const uint8_t *buf, size_t len)
+{
+  while (len >= CRC_SLICES) {
+    crc ^= (buf[0] << 8) | buf[1];
+#if CRC_SLICES == 8
+    crc = T16(7, crc >> 8) ^ T16(6, crc & 0xFF) ^
+          T16(5, buf[2])   ^ T16(4, buf[3])     ^
+          T16(3, buf[4])   ^ T16(2, buf[5])     ^
+          T16(1, buf[6])   ^ T16(0, buf[7]);
+#else
+    crc = T16(3, crc >> 8) ^ T16(2, crc & 0xFF) ^
+          T16(1, buf[2])   ^ T16(0, buf[3]);
+#endif
+    buf += CRC_SLICES;
+    len -= CRC_SLICES;
+  }
+
+  while (len--) {
+    crc = (crc << 8) ^ T16(0, (crc >> 8) ^ *buf++);
+  }
+
+  return crc;
+}
+
+/*
+ * GDL90 FCS is the "augmented" form of CRC-CCITT: the register holds
+ * the plain CRC of all but the last two bytes, XOR-ed with those two.
+ * Shift the running state through two zero bytes, run the sliced
+ * kernel and fold the tail in at the end.
+ */
+uint16_t crc16_gdl90(uint16_t crc, const uint8_t *buf, size_t len)
+{
+  if (len < 2) {
+    while (len--) {
+      crc = T16(0, crc >> 8) ^ (crc << 8) ^ *buf++;
+    }
+    return crc;
+  }
+
+  crc = (crc << 8) ^ T16(0, crc >> 8);
+  crc = (crc << 8) ^ T16(0, crc >> 8);
+  crc = crc16_ccitt(crc, buf, len - 2);
+
+  return crc ^ ((buf[len - 2] << 8) | buf[len - 1]);
+}
+
+uint8_t crc8_107(uint8_t crc, const uint8_t *buf, size_t len)
+{
+  while (len >= CRC_SLICES) {
+#if CRC_SLICES == 8
+    crc = T8(7, crc ^ buf[0]) ^ T8(6, buf[1]) ^ T8(5, buf[2]) ^ T8(4, buf[3]) ^
+          T8(3, buf[4])       ^ T8(2, buf[5]) ^ T8(1, buf[6]) ^ T8(0, buf[7]);
+#else
+    crc = T8(3, crc ^ buf[0]) ^ T8(2, buf[1]) ^ T8(1, buf[2]) ^ T8(0, buf[3]);
+#endif
+    buf += CRC_SLICES;
+    len -= CRC_SLICES;
+  }
+
+  while (len--) {
+    crc = T8(0, crc ^ *buf++);
+  }
+
+  return crc;
+}
@@ -0,0 +1,112 @@
+/*
+ * crc_fast.h
+ *
+ * Table driven, slice-by-N CRC routines of the SoftRF radio protocols.
+ * Lookup tables are built by the compiler and live in flash.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CRC_FAST_H
+#define CRC_FAST_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(ESP8266) || defined(ESP32) || defined(__ASR6501__)
+#include <pgmspace.h>
+#endif
+
+#if defined(ENERGIA_ARCH_CC13XX) || defined(ENERGIA_ARCH_CC13X2) || \
+    defined(ARDUINO_ARCH_STM32)
+#include <avr/pgmspace.h>
+#endif
+
+#if !defined(PROGMEM)
+#define PROGMEM
+#endif
+#if !defined(pgm_read_byte)
+#define pgm_read_byte(addr)     (*(const uint8_t  *)(addr))
+#endif
+#if !defined(pgm_read_word)
+#define pgm_read_word(addr)     (*(const uint16_t *)(addr))
+#endif
+
+/* bytes consumed per step of the sliced kernels, 4 or 8 */
+#if !defined(CRC_SLICES)
+#if defined(RASPBERRY_PI) || defined(ESP32)
+#define CRC_SLICES              8
+#else
+#define CRC_SLICES              4
+#endif
+#endif /* CRC_SLICES */
+
+#define CRC16_CCITT_POLY        0x1021
+#define CRC8_107_POLY           0x07
+
+#define CRC16_CCITT_FFFF_SEED   0xFFFF
+#define CRC16_CCITT_0000_SEED   0x0000
+#define CRC16_GDL90_SEED        0x0000
+#define CRC8_107_SEED           0x71
+
+/* bit at a time references, usable in constant expressions */
+constexpr uint16_t crc16_ccitt_bits(uint16_t crc, int bits)
+{
+  return bits == 0 ? crc :
+         crc16_ccitt_bits((crc & 0x8000) ? (uint16_t) ((crc << 1) ^ CRC16_CCITT_POLY) :
+                                           (uint16_t)  (crc << 1), bits - 1);
+}
+
+constexpr uint16_t crc16_ccitt_byte(uint16_t crc, uint8_t c)
+{
+  return crc16_ccitt_bits((uint16_t) (crc ^ (c << 8)), 8);
+}
+
+constexpr uint8_t crc8_107_bits(uint8_t crc, int bits)
+{
+  return bits == 0 ? crc :
+         crc8_107_bits((crc & 0x80) ? (uint8_t) ((crc << 1) ^ CRC8_107_POLY) :
+                                      (uint8_t)  (crc << 1), bits - 1);
+}
+
+constexpr uint8_t crc8_107_byte(uint8_t crc, uint8_t c)
+{
+  return crc8_107_bits((uint8_t) (crc ^ c), 8);
+}
+
+/* CRC-CCITT state after the NRF905 "address" bytes 31 FA B6 of Legacy */
+constexpr uint16_t CRC16_LEGACY_SEED =
+  crc16_ccitt_byte(crc16_ccitt_byte(crc16_ccitt_byte(CRC16_CCITT_FFFF_SEED,
+                                                     0x31), 0xFA), 0xB6);
+
+/* buffer at a time updates, chain them to continue a running CRC */
+uint16_t crc16_ccitt(uint16_t crc, const uint8_t *buf, size_t len);
+uint16_t crc16_gdl90(uint16_t crc, const uint8_t *buf, size_t len);
+uint8_t  crc8_107   (uint8_t  crc, const uint8_t *buf, size_t len);
+
+extern const uint16_t crc16_ccitt_table[CRC_SLICES][256];
+extern const uint8_t  crc8_107_table   [CRC_SLICES][256];
+
+/* byte at a time steps, for loops that do other work on each byte too */
+static inline uint16_t crc16_ccitt_update(uint16_t crc, uint8_t c)
+{
+  return (crc << 8) ^ pgm_read_word(&crc16_ccitt_table[0][(crc >> 8) ^ c]);
+}
+
+static inline uint8_t crc8_107_update(uint8_t crc, uint8_t c)
+{
+  return pgm_read_byte(&crc8_107_table[0][crc ^ c]);
+}
+
+#endif /* CRC_FAST_H */
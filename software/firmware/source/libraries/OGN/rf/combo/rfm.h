@@ -202,10 +202,10 @@ class RFM_TRX
      // printf("ReadByte(0x%02X) => 0x%02X\n", Addr, *Ret );
      return *Ret; }
 
-   uint16_t ReadWord (uint8_t Addr=0)
-   { uint16_t *Ret = (uint16_t *)Block_Read(2, Addr);
-     // printf("ReadWord(0x%02X) => 0x%04X\n", Addr, SwapBytes(*Ret) );
-     return SwapBytes(*Ret); }
+   uint16_t ReadWord (uint8_t Addr=0)                                   // Block_Buffer+1 is not aligned for a 16-bit load
+   { uint8_t *Ret = Block_Read(2, Addr);
+     // printf("ReadWord(0x%02X) => 0x%02X%02X\n", Addr, Ret[0], Ret[1] );
+     return ((uint16_t)Ret[0]<<8) | Ret[1]; }
 
    void WriteBytes(const uint8_t *Data, uint8_t Len, uint8_t Addr=0)
    { Block_Write(Data, Len, Addr); }
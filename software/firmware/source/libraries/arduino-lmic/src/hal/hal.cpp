@@ -25,6 +25,7 @@
 #include "hal.h"
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 
 // -----------------------------------------------------------------------------
 // I/O
@@ -266,11 +267,23 @@ u1_t hal_spi (u1_t out) {
     return res;
 }
 
+void hal_spi_block (u1_t* buf, u1_t len) {
+#if defined(HAL_SPI_BURST)
+    SPI.transfer(buf, len);
+#else
+    for (u1_t i=0; i<len; i++) {
+        buf[i] = hal_spi(buf[i]);
+    }
+#endif
+}
+
+#if defined(HAL_SPI_BURST)
 static u1_t spi_buf[MAX_LEN_FRAME + 1];
+#endif
 
 u1_t hal_spi_read_reg (u1_t addr) {
     hal_pin_nss(0);
-#if !defined(ENERGIA_ARCH_CC13XX) && !defined(ENERGIA_ARCH_CC13X2)
+#if !defined(HAL_SPI_BURST)
     hal_spi(addr & 0x7F);
     u1_t val = hal_spi(0x00);
 #else
@@ -285,7 +298,7 @@ u1_t hal_spi_read_reg (u1_t addr) {
 
 void hal_spi_write_reg (u1_t addr, u1_t data) {
     hal_pin_nss(0);
-#if !defined(ENERGIA_ARCH_CC13XX) && !defined(ENERGIA_ARCH_CC13X2)
+#if !defined(HAL_SPI_BURST)
     hal_spi(addr | 0x80);
     hal_spi(data);
 #else
@@ -298,21 +311,20 @@ void hal_spi_write_reg (u1_t addr, u1_t data) {
 
 void hal_spi_read_buf (u1_t addr, u1_t* buf, u1_t len, u1_t inv) {
     hal_pin_nss(0);
-#if !defined(ENERGIA_ARCH_CC13XX) && !defined(ENERGIA_ARCH_CC13X2)
     hal_spi(addr & 0x7F);
+#if !defined(HAL_SPI_BURST)
     u1_t i=0;
     for (i=0; i<len; i++) {
         buf[i] = (inv == 0 ? hal_spi(0x00) : ~(hal_spi(0x00)));
     }
 #else
-    spi_buf[0] = addr & 0x7F;
-    u1_t i = 0;
-    for (i=0; i<len; i++) {
-        spi_buf[i+1] = 0;
-    }
-    SPI.transfer(spi_buf, len+1);
-    for (i=0; i<len; i++) {
-        buf[i] = (inv == 0 ? spi_buf[i+1] : ~spi_buf[i+1]);
+    // FIFO goes straight into the caller's buffer, then gets inverted in place
+    memset(buf, 0, len);
+    SPI.transfer(buf, len);
+    if (inv) {
+        for (u1_t i=0; i<len; i++) {
+            buf[i] = ~buf[i];
+        }
     }
 #endif
     hal_pin_nss(1);
@@ -321,13 +333,14 @@ void hal_spi_read_buf (u1_t addr, u1_t* buf, u1_t len, u1_t inv) {
 
 void hal_spi_write_buf (u1_t addr, u1_t* buf, u1_t len, u1_t inv) {
     hal_pin_nss(0);
-#if !defined(ENERGIA_ARCH_CC13XX) && !defined(ENERGIA_ARCH_CC13X2)
+#if !defined(HAL_SPI_BURST)
     hal_spi(addr | 0x80);
     u1_t i = 0;
     for (i=0; i<len; i++) {
         hal_spi(inv == 0 ? buf[i] : ~buf[i]);
     }
 #else
+    // the bulk transfer overwrites what it sends, so work on a copy
     spi_buf[0] = addr | 0x80;
     u1_t i = 0;
     for (i=0; i<len; i++) {
@@ -89,6 +89,19 @@ void hal_spi_read_buf (u1_t addr, u1_t* buf, u1_t len, u1_t inv);
  */
 void hal_spi_write_buf (u1_t addr, u1_t* buf, u1_t len, u1_t inv);
 
+// SPI drivers able to exchange a whole buffer in one call
+#if defined(ENERGIA_ARCH_CC13XX) || defined(ENERGIA_ARCH_CC13X2) || \
+    defined(ESP32) || defined(ARDUINO_ARCH_NRF52) || \
+    defined(ARDUINO_ARCH_STM32) || defined(RASPBERRY_PI)
+#define HAL_SPI_BURST
+#endif
+
+/*
+ * exchange 'len' bytes with radio in place, NSS is left to the caller.
+ *   - a single bulk transfer where the SPI driver has one
+ */
+void hal_spi_block (u1_t* buf, u1_t len);
+
 /*
  * disable all CPU interrupts.
  *   - might be invoked nested
@@ -94,6 +94,14 @@ byte SPIClass::transfer(byte _data) {
   return data;
 }
 
+void SPIClass::transfer(void *_buf, size_t _count) {
+  if (_spi_num == SPI_AUX) {
+    bcm2835_aux_spi_transfern((char *) _buf, _count);
+  } else {
+    bcm2835_spi_transfern((char *) _buf, _count);
+  }
+}
+
 SPIClass SPI0(SPI_PRI);
 SPIClass SPI1(SPI_AUX);
 
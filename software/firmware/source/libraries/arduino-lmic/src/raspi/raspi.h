@@ -155,6 +155,7 @@ class SPIClass {
   public:
     SPIClass(uint8_t spi_bus=SPI_PRI);
     byte transfer(byte _data);
+    void transfer(void *_buf, size_t _count);
     // SPI Configuration methods
     void begin(); // Default
     void end();
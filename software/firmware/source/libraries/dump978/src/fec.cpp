@@ -24,6 +24,8 @@
 
 #include "uat.h"
 #include "fec/rs.h"
+#include "fec/char.h"
+#include "fec/rs-common.h"
 
 static void *rs_uplink;
 static void *rs_adsb_short;
@@ -34,6 +36,9 @@ static void *rs_adsb_long;
 
 void init_fec(void)
 {
+    if (rs_adsb_long)
+        return;
+
     rs_adsb_short = init_rs_char(8, /* gfpoly */ ADSB_POLY, /* fcr */ 120, /* prim */ 1, /* nroots */ 12, /* pad */ 225);
     rs_adsb_long  = init_rs_char(8, /* gfpoly */ ADSB_POLY, /* fcr */ 120, /* prim */ 1, /* nroots */ 14, /* pad */ 207);
 #if !defined(ESP8266) && !defined(ENERGIA_ARCH_CC13XX) && !defined(ENERGIA_ARCH_CC13X2) && \
@@ -42,31 +47,165 @@ void init_fec(void)
 #endif
 }
 
-int correct_adsb_frame(uint8_t *to, int *rs_errors)
+// Checks whether the first N bytes of data are a codeword, i.e. whether
+// all ROOTS syndromes are zero. Same evaluation as decode_rs_char() does
+// before anything else, with the code parameters known at compile time.
+// Uses the GF tables of the codec passed in; all codes here share
+// the field (ADSB_POLY == UPLINK_POLY) and fcr 120.
+template <int N, int ROOTS>
+static bool syndromes_zero(void *p, const uint8_t *data)
+{
+    const struct rs *rs = (const struct rs *) p;
+    const data_t *alpha_to = rs->alpha_to;
+    const data_t *index_of = rs->index_of;
+    uint8_t s[ROOTS];
+    uint8_t syn_error = 0;
+    int i, j;
+
+    for (i = 0; i < ROOTS; ++i)
+        s[i] = data[0];
+
+    for (j = 1; j < N; ++j) {
+        for (i = 0; i < ROOTS; ++i) {
+            if (s[i] == 0) {
+                s[i] = data[j];
+            } else {
+                int x = index_of[s[i]] + 120 + i;
+                if (x >= 255)
+                    x -= 255;
+                s[i] = data[j] ^ alpha_to[x];
+            }
+        }
+    }
+
+    for (i = 0; i < ROOTS; ++i)
+        syn_error |= s[i];
+
+    return syn_error == 0;
+}
+
+// Roots left unused by erasures, so that a block which is beyond repair
+// is still seen as such instead of being "corrected" into another code word.
+#define ERASURE_SPARE_ROOTS 4
+
+// Picks the erasures that fall within the first N bytes and maps them
+// to positions in the padded block that decode_rs_char() works on.
+// Returns -1 if there are more of them than ROOTS - ERASURE_SPARE_ROOTS.
+template <int N, int ROOTS>
+static int map_erasures(const int *erasures, int n_erasures, int *eras_pos)
+{
+    int i, no_eras = 0;
+
+    for (i = 0; i < n_erasures; ++i) {
+        if (erasures[i] < 0 || erasures[i] >= N)
+            continue;
+        if (no_eras == ROOTS - ERASURE_SPARE_ROOTS)
+            return -1;
+        eras_pos[no_eras++] = erasures[i] + (255 - N);
+    }
+
+    return no_eras;
+}
+
+// decode_rs_char() may place "errors" in the zero padding of the
+// shortened code. Such a block is beyond repair, not corrected.
+template <int N>
+static bool within_frame(const int *eras_pos, int n_corrected)
+{
+    int i;
+
+    for (i = 0; i < n_corrected; ++i) {
+        if (eras_pos[i] < 255 - N)
+            return false;
+    }
+
+    return true;
+}
+
+static int correct_adsb_long(uint8_t *to, const int *erasures, int n_erasures,
+                             int *rs_errors)
 {
-    // Try decoding as a Long UAT.
-    // We rely on decode_rs_char not modifying the data if there were
-    // uncorrectable errors.
-    int n_corrected = decode_rs_char(rs_adsb_long, to, NULL, 0);
-    if (n_corrected >= 0 && n_corrected <= 7 && (to[0]>>3) != 0) {
+    uint8_t block[LONG_FRAME_BYTES];
+    int eras_pos[14];
+    int no_eras;
+    int n_corrected = 0;
+
+    // Too many erasures to use: decode as if there were no hints.
+    no_eras = map_erasures<LONG_FRAME_BYTES, 14>(erasures, n_erasures, eras_pos);
+    if (no_eras < 0)
+        no_eras = 0;
+
+    // A block is decoded in a copy, so that a rejected correction
+    // leaves 'to' as it was. An erasure costs one root, an error two.
+    memcpy(block, to, sizeof(block));
+    if (!syndromes_zero<LONG_FRAME_BYTES, 14>(rs_adsb_long, block))
+        n_corrected = decode_rs_char(rs_adsb_long, block, eras_pos, no_eras);
+    if (n_corrected >= 0 && 2 * n_corrected - no_eras <= 14 &&
+        within_frame<LONG_FRAME_BYTES>(eras_pos, n_corrected) &&
+        (block[0]>>3) != 0) {
         // Valid long frame.
+        memcpy(to, block, sizeof(block));
         *rs_errors = n_corrected;
         return 2;
     }
 
-    // Retry as Basic UAT
-    n_corrected = decode_rs_char(rs_adsb_short, to, NULL, 0);
-    if (n_corrected >= 0 && n_corrected <= 6 && (to[0]>>3) == 0) {
+    return -1;
+}
+
+static int correct_adsb_short(uint8_t *to, const int *erasures, int n_erasures,
+                              int *rs_errors)
+{
+    uint8_t block[SHORT_FRAME_BYTES];
+    int eras_pos[12];
+    int no_eras;
+    int n_corrected = 0;
+
+    no_eras = map_erasures<SHORT_FRAME_BYTES, 12>(erasures, n_erasures, eras_pos);
+    if (no_eras < 0)
+        no_eras = 0;
+
+    memcpy(block, to, sizeof(block));
+    if (!syndromes_zero<SHORT_FRAME_BYTES, 12>(rs_adsb_short, block))
+        n_corrected = decode_rs_char(rs_adsb_short, block, eras_pos, no_eras);
+    if (n_corrected >= 0 && 2 * n_corrected - no_eras <= 12 &&
+        within_frame<SHORT_FRAME_BYTES>(eras_pos, n_corrected) &&
+        (block[0]>>3) == 0) {
         // Valid short frame
+        memcpy(to, block, sizeof(block));
         *rs_errors = n_corrected;
         return 1;
     }
 
+    return -1;
+}
+
+int correct_adsb_frame_erasures(uint8_t *to, const int *erasures,
+                                int n_erasures, int *rs_errors)
+{
+    int frametype;
+
+    // The payload type code says which length is more likely,
+    // it may be in error itself so the other one is tried as well.
+    if ((to[0]>>3) != 0) {
+        if ((frametype = correct_adsb_long(to, erasures, n_erasures, rs_errors)) > 0 ||
+            (frametype = correct_adsb_short(to, erasures, n_erasures, rs_errors)) > 0)
+            return frametype;
+    } else {
+        if ((frametype = correct_adsb_short(to, erasures, n_erasures, rs_errors)) > 0 ||
+            (frametype = correct_adsb_long(to, erasures, n_erasures, rs_errors)) > 0)
+            return frametype;
+    }
+
     // Failed.
     *rs_errors = 9999;
     return -1;
 }
 
+int correct_adsb_frame(uint8_t *to, int *rs_errors)
+{
+    return correct_adsb_frame_erasures(to, NULL, 0, rs_errors);
+}
+
 #if !defined(ESP8266) && !defined(ENERGIA_ARCH_CC13XX) && !defined(ENERGIA_ARCH_CC13X2) && \
     !defined(__ASR6501__) && !defined(ARDUINO_ARCH_STM32)
 int correct_uplink_frame(uint8_t *from, uint8_t *to, int *rs_errors)
@@ -82,7 +221,9 @@ int correct_uplink_frame(uint8_t *from, uint8_t *to, int *rs_errors)
             blockdata[i] = from[i * UPLINK_FRAME_BLOCKS + block];
 
         // error-correct in place
-        n_corrected = decode_rs_char(rs_uplink, blockdata, NULL, 0);
+        n_corrected = 0;
+        if (!syndromes_zero<UPLINK_BLOCK_BYTES, 20>(rs_uplink, blockdata))
+            n_corrected = decode_rs_char(rs_uplink, blockdata, NULL, 0);
         if (n_corrected < 0 || n_corrected > 10) {
             // Failed
             *rs_errors = 9999;
@@ -30,6 +30,17 @@ void init_fec(void);
  */
 int correct_adsb_frame(uint8_t *to, int *rs_errors);
 
+/* As correct_adsb_frame(), with hints on which bytes are unreliable.
+ *
+ * 'erasures' lists 'n_erasures' distinct byte offsets within 'to'.
+ * An erased byte costs the code half of what an unknown error does.
+ * Hints are used only while 4 parity bytes are left over for detection,
+ * i.e. up to 10 (long) or 8 (short) of them; with more, none are used.
+ * A correction that needs symbols in the code's zero padding is refused.
+ */
+int correct_adsb_frame_erasures(uint8_t *to, const int *erasures,
+                                int n_erasures, int *rs_errors);
+
 /* Deinterleave and correct an uplink frame.
  *
  * 'from' should point to UPLINK_FRAME_BYTES of interleaved input data